@@ -9,6 +9,8 @@
 
 #include <cstdlib>
 #include <utility> // pair
+#include <limits> // numeric_limits
+#include <stdexcept> // runtime_error, invalid_argument
 #include <iostream> // cout, cin, cerr
 #include <iomanip> // setw, setprecision, time
 
@@ -26,6 +28,15 @@
 
 #include <algorithm>
 
+// need these for multi-threaded pipelines
+#include <atomic>
+#include <thread>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <system_error> // system_error, thrown when a thread cannot be started
+
 // Constants
 static const double EPS = (3.0e-12);
 
@@ -46,10 +57,17 @@ static const double ETA = sqrt(MU / EPSILON); // Impedance of free space
 static const bool TE = true; // TE polarisation 
 static const bool TM = false; // TM polarisation
 
+#include "Data_Prep.h"
 #include "Templates.h"
 #include "Useful.h"
 
 #include "Laser_Model.h"
+#include "Device_Population.h"
+
+#include "Pipeline.h"
+#include "LI_Workflow.h"
+
+#include "Sensitivity.h"
 
 #include "Test_Functions.h"
 
@@ -0,0 +1,277 @@
+#ifndef DATA_PREP_H
+#define DATA_PREP_H
+
+// Template functions for preparing multi-column measured data sets before fitting or comparison with the model
+// A data set is a list of columns of equal length, one of which is the key column, e.g. current
+// Sorting computes a single permutation from the key column and applies it to every column in place
+// Duplicate keys can then be merged and the columns resampled onto a common grid
+
+namespace data_prep {
+
+	static const size_t PAR_SORT_MIN = 65536; // smallest number of elements worth giving to a sorting thread
+
+	template <class T> bool columns_ok(std::vector< std::vector<T>* > &cols, int key, std::string &reason)
+	{
+		// check that a list of columns is usable: key is a valid column index and every column has the same length
+
+		bool c1 = cols.size() > 0 ? true : false;
+		bool c2 = (key >= 0 && key < static_cast<int>(cols.size())) ? true : false;
+		bool c3 = true;
+
+		for (size_t c = 0; c < cols.size(); c++) {
+			if (cols[c] == nullptr || cols[c]->size() != cols[0]->size()) c3 = false;
+		}
+
+		if (!c1) reason += "No columns supplied\n";
+		if (!c2) reason += "Key column index is out of range\n";
+		if (!c3) reason += "Columns have different sizes\n";
+
+		return (c1 && c2 && c3);
+	}
+
+	template <class T> void sort_permutation(std::vector<T> &key, std::vector<size_t> &perm, int n_threads = 0)
+	{
+		// Compute the permutation that sorts key into ascending order, key itself is not changed
+		// key[perm[0]] <= key[perm[1]] <= ... and equal keys keep their original order
+		// Inputs of more than PAR_SORT_MIN elements are split into chunks that are sorted on separate threads
+		// the sorted chunks are then merged pairwise, also in parallel
+		// a chunk or merge that cannot be given a thread is done on the calling thread, so every thread started is joined
+		// n_threads = 0 uses all available hardware threads
+
+		size_t n = key.size();
+
+		perm.resize(n);
+		for (size_t i = 0; i < n; i++) perm[i] = i;
+
+		auto less = [&key](size_t a, size_t b) { return key[a] < key[b]; };
+
+		size_t n_max = n_threads > 0 ? static_cast<size_t>(n_threads) : std::max(1u, std::thread::hardware_concurrency());
+		size_t n_chunks = std::min(n_max, n / PAR_SORT_MIN);
+
+		if (n_chunks <= 1) {
+			std::stable_sort(perm.begin(), perm.end(), less);
+			return;
+		}
+
+		// bounds[c] is the start of the c^{th} sorted run
+		std::vector<size_t> bounds(n_chunks + 1);
+		for (size_t c = 0; c <= n_chunks; c++) bounds[c] = (c * n) / n_chunks;
+
+		auto sort_run = [&perm, &bounds, &less](size_t c) { std::stable_sort(perm.begin() + bounds[c], perm.begin() + bounds[c + 1], less); };
+
+		// runs 2p and 2p + 1 are merged into one
+		auto merge_runs = [&perm, &bounds, &less](size_t p) { std::inplace_merge(perm.begin() + bounds[2 * p], perm.begin() + bounds[2 * p + 1], perm.begin() + bounds[2 * p + 2], less); };
+
+		// reserving first means push_back cannot throw once a thread has been created
+		std::vector<std::thread> workers;
+		workers.reserve(n_chunks);
+
+		size_t c = 0;
+		for (; c < n_chunks; c++) {
+			try {
+				workers.push_back( std::thread(sort_run, c) );
+			}
+			catch (std::system_error &) {
+				break;
+			}
+		}
+		for (; c < n_chunks; c++) sort_run(c);
+		for (size_t t = 0; t < workers.size(); t++) workers[t].join();
+
+		while (bounds.size() > 2) {
+			size_t n_runs = bounds.size() - 1;
+			size_t n_pairs = n_runs / 2;
+
+			std::vector<size_t> next;
+			for (size_t p = 0; p < n_pairs; p++) next.push_back(bounds[2 * p]);
+			if (n_runs % 2 == 1) next.push_back(bounds[n_runs - 1]); // odd run out is carried to the next round
+			next.push_back(n);
+
+			workers.clear();
+			size_t p = 0;
+			for (; p < n_pairs; p++) {
+				try {
+					workers.push_back( std::thread(merge_runs, p) );
+				}
+				catch (std::system_error &) {
+					break;
+				}
+			}
+			for (; p < n_pairs; p++) merge_runs(p);
+			for (size_t t = 0; t < workers.size(); t++) workers[t].join();
+
+			bounds.swap(next);
+		}
+	}
+
+	template <class T> void apply_permutation(std::vector<size_t> &perm, std::vector<T> &col, std::vector<bool> &done)
+	{
+		// Rearrange col in place so that new col[i] = old col[perm[i]]
+		// each cycle of the permutation is followed once, so only one element of col is held outside the vector at a time
+		// done is workspace that can be reused between calls to avoid re-allocation
+
+		size_t n = perm.size();
+
+		done.assign(n, false);
+
+		for (size_t i = 0; i < n; i++) {
+			if (!done[i]) {
+				T tmp = col[i];
+				size_t j = i;
+				while (perm[j] != i) {
+					col[j] = col[perm[j]];
+					done[j] = true;
+					j = perm[j];
+				}
+				col[j] = tmp;
+				done[j] = true;
+			}
+		}
+	}
+
+	template <class T> void co_sort(std::vector< std::vector<T>* > &cols, int key = 0, int n_threads = 0)
+	{
+		// Sort the column cols[key] into ascending order while making the corresponding rearrangement of every other column
+		// Only one permutation is computed and it is applied to each column in place
+
+		try {
+			std::string reason;
+
+			if (columns_ok(cols, key, reason)) {
+				std::vector<size_t> perm;
+				std::vector<bool> done;
+
+				sort_permutation(*cols[key], perm, n_threads);
+
+				for (size_t c = 0; c < cols.size(); c++) apply_permutation(perm, *cols[c], done);
+			}
+			else {
+				reason = "Error: data_prep::co_sort(std::vector< std::vector<T>* > &cols, int key, int n_threads)\n" + reason;
+				throw std::invalid_argument(reason);
+			}
+		}
+		catch (std::invalid_argument &e) {
+			std::cerr << e.what();
+		}
+	}
+
+	template <class T> int dedupe(std::vector< std::vector<T>* > &cols, int key = 0, bool average = true, T tol = T(0))
+	{
+		// Merge rows with duplicate keys, cols must already be sorted by cols[key], e.g. by co_sort
+		// keys within tol of the first key of a run are treated as duplicates
+		// if average is true the merged row holds the mean of each column over the run, otherwise the first row of the run is kept
+		// Columns are compacted in place and the new number of rows is returned
+
+		try {
+			std::string reason;
+
+			if (columns_ok(cols, key, reason)) {
+				std::vector<T> &k = *cols[key];
+				size_t n = k.size(), w = 0, i = 0;
+
+				while (i < n) {
+					size_t j = i + 1;
+					while (j < n && k[j] - k[i] <= tol) j++;
+
+					for (size_t c = 0; c < cols.size(); c++) {
+						std::vector<T> &col = *cols[c];
+						if (average && j - i > 1 && static_cast<int>(c) != key) {
+							T sum = T(0);
+							for (size_t r = i; r < j; r++) sum += col[r];
+							col[w] = sum / static_cast<T>(j - i);
+						}
+						else {
+							col[w] = col[i];
+						}
+					}
+
+					w++;
+					i = j;
+				}
+
+				for (size_t c = 0; c < cols.size(); c++) cols[c]->resize(w);
+
+				return static_cast<int>(w);
+			}
+			else {
+				reason = "Error: data_prep::dedupe(std::vector< std::vector<T>* > &cols, int key, bool average, T tol)\n" + reason;
+				throw std::invalid_argument(reason);
+			}
+		}
+		catch (std::invalid_argument &e) {
+			std::cerr << e.what();
+			return 0;
+		}
+	}
+
+	template <class T> void uniform_grid(T x0, T x1, int n, std::vector<T> &grid)
+	{
+		// n equally spaced points from x0 to x1 inclusive
+		grid.resize(std::max(n, 0));
+		if (n == 1) grid[0] = x0;
+		for (int i = 0; i < n && n > 1; i++) grid[i] = x0 + (i * (x1 - x0)) / (n - 1);
+	}
+
+	template <class T> void resample(std::vector<T> &x, std::vector< std::vector<T>* > &ys, std::vector<T> &grid, std::vector< std::vector<T> > &out)
+	{
+		// Linearly interpolate each column ys[c], sampled at x, onto grid, out[c] holds the resampled column
+		// x must be strictly ascending, apply co_sort and dedupe first if necessary
+		// points of grid outside [x[0], x[n-1]] take the value at the nearest end point
+		// The interval and weight for each grid point are found once in a single walk through x
+		// every column is then interpolated with the same branch-free loop
+
+		try {
+			bool c1 = x.size() > 0 ? true : false;
+			bool c2 = true;
+			for (size_t c = 0; c < ys.size(); c++) if (ys[c] == nullptr || ys[c]->size() != x.size()) c2 = false;
+
+			if (c1 && c2) {
+				size_t n = x.size(), m = grid.size();
+
+				std::vector<size_t> idx(m);
+				std::vector<T> wgt(m);
+
+				size_t j = 0;
+				for (size_t k = 0; k < m; k++) {
+					if (k > 0 && grid[k] < grid[k - 1]) j = 0; // grid is not ascending, restart the walk
+					while (j + 2 < n && x[j + 1] < grid[k]) j++;
+
+					if (n > 1) {
+						T t = (grid[k] - x[j]) / (x[j + 1] - x[j]);
+						wgt[k] = std::min(T(1), std::max(T(0), t));
+					}
+					else {
+						wgt[k] = T(0);
+					}
+					idx[k] = j;
+				}
+
+				out.resize(ys.size());
+
+				for (size_t c = 0; c < ys.size(); c++) {
+					const T *y = ys[c]->data();
+					out[c].resize(m);
+					T *o = out[c].data();
+
+					if (n > 1) {
+						for (size_t k = 0; k < m; k++) o[k] = y[idx[k]] + wgt[k] * (y[idx[k] + 1] - y[idx[k]]);
+					}
+					else {
+						for (size_t k = 0; k < m; k++) o[k] = y[0];
+					}
+				}
+			}
+			else {
+				std::string reason = "Error: data_prep::resample(std::vector<T> &x, std::vector< std::vector<T>* > &ys, std::vector<T> &grid, std::vector< std::vector<T> > &out)\n";
+				if (!c1) reason += "x has no elements\n";
+				if (!c2) reason += "Columns do not have the same size as x\n";
+				throw std::invalid_argument(reason);
+			}
+		}
+		catch (std::invalid_argument &e) {
+			std::cerr << e.what();
+		}
+	}
+}
+
+#endif
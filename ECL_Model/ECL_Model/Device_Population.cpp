@@ -0,0 +1,310 @@
+#ifndef ATTACH_H
+#include "Attach.h"
+#endif
+
+// Definition of the class device_population
+// Column-wise storage for the parameters of a large number of External Cavity Lasers
+// The model for an ECL LI curve is described in the paper
+// Power-efficient {III-V/Silicon} external cavity {DBR} lasers, Zilkie et al, Opt. Expr., 20 (21), 2012
+
+device_population::device_population()
+{
+	// Default Constructor
+	n_dev = n_cap = stride = 0;
+	derived = false;
+	base = nullptr;
+}
+
+device_population::device_population(int n_devices)
+{
+	n_dev = n_cap = stride = 0;
+	derived = false;
+	base = nullptr;
+
+	resize(n_devices);
+}
+
+device_population::device_population(const device_population &dp)
+{
+	// copy constructor
+	// base must point into the new arena, not the arena of dp
+	n_dev = n_cap = stride = 0;
+	derived = false;
+	base = nullptr;
+
+	*this = dp;
+}
+
+device_population& device_population::operator=(const device_population &dp)
+{
+	if (this != &dp) {
+		allocate(dp.n_cap, false);
+
+		n_dev = dp.n_dev;
+		derived = dp.derived;
+
+		for (int c = 0; c < N_POP_COLS; c++) {
+			std::copy(dp.base + c * dp.stride, dp.base + c * dp.stride + dp.n_dev, base + c * stride);
+		}
+	}
+
+	return *this;
+}
+
+void device_population::allocate(int n_devices, bool keep)
+{
+	// Allocate a single block large enough to hold every column
+	// Each column is padded to a multiple of ALIGN_DOUBLES so that every column begins on a 64 byte boundary
+	// if keep is true the existing n_dev entries of each column are copied into the new block
+
+	try {
+		if (n_devices >= 0) {
+			int new_stride = ALIGN_DOUBLES * ( (n_devices + ALIGN_DOUBLES - 1) / ALIGN_DOUBLES );
+
+			// extra ALIGN_DOUBLES elements allow the start of the block to be moved onto an aligned address
+			std::vector<double> new_arena( static_cast<size_t>(N_POP_COLS) * new_stride + ALIGN_DOUBLES, 0.0 );
+
+			size_t addr = reinterpret_cast<size_t>( new_arena.data() );
+			size_t shift = ( (ALIGN_DOUBLES * sizeof(double)) - (addr % (ALIGN_DOUBLES * sizeof(double))) ) % (ALIGN_DOUBLES * sizeof(double));
+			double *new_base = new_arena.data() + shift / sizeof(double);
+
+			if (keep && base != nullptr) {
+				int n_keep = std::min(n_dev, n_devices);
+				for (int c = 0; c < N_POP_COLS; c++) {
+					std::copy(base + c * stride, base + c * stride + n_keep, new_base + c * new_stride);
+				}
+			}
+
+			arena.swap(new_arena);
+			base = new_base;
+			stride = new_stride;
+			n_cap = n_devices;
+		}
+		else {
+			std::string reason = "Error: device_population::allocate(int n_devices, bool keep)\n";
+			reason += "Number of devices is negative\n";
+			throw std::runtime_error(reason);
+		}
+	}
+	catch (std::runtime_error &e) {
+		std::cerr << e.what();
+	}
+}
+
+void device_population::reserve(int n_devices)
+{
+	// make space for n_devices without changing the number of stored devices
+	if (n_devices > n_cap) allocate(n_devices, true);
+}
+
+void device_population::resize(int n_devices)
+{
+	// change the number of stored devices, new devices have all parameters set to zero and are not valid
+	if (n_devices > n_cap) allocate(n_devices, true);
+
+	if (n_devices > n_dev) {
+		for (int c = 0; c < N_POP_COLS; c++) {
+			std::fill(base + c * stride + n_dev, base + c * stride + n_devices, 0.0);
+		}
+	}
+
+	n_dev = std::max(0, std::min(n_devices, n_cap));
+	derived = false;
+}
+
+void device_population::clear()
+{
+	// remove all devices, memory is retained
+	n_dev = 0;
+	derived = false;
+}
+
+int device_population::add_device(double coupEff, double intQE, lengths &theLength, reflections &theRefs, losses &theLoss, dcvals &theDC)
+{
+	// append a device to the population, return its index
+	// storage grows geometrically so that repeated calls are cheap
+
+	if (n_dev == n_cap) allocate(std::max(2 * n_cap, 64), true);
+
+	int i = n_dev;
+	n_dev++;
+
+	set_device(i, coupEff, intQE, theLength, theRefs, theLoss, theDC);
+
+	return i;
+}
+
+void device_population::set_device(int i, double coupEff, double intQE, lengths &theLength, reflections &theRefs, losses &theLoss, dcvals &theDC)
+{
+	// Copy the parameters of a single device into the population
+	// No validation is performed here, call validate() or compute_derived() once the population is filled
+
+	try {
+		if (i >= 0 && i < n_dev) {
+			base[COL_ETA * stride + i] = coupEff;
+			base[COL_ETAI * stride + i] = intQE;
+			base[COL_L * stride + i] = theLength.get_L();
+			base[COL_LGOUT * stride + i] = theLength.get_Lg();
+			base[COL_RG * stride + i] = theRefs.get_Rg();
+			base[COL_RR * stride + i] = theRefs.get_Rr();
+			base[COL_ALPHA * stride + i] = theLoss.get_alpha();
+			base[COL_ALPHAG * stride + i] = theLoss.get_alphag();
+			base[COL_ZT * stride + i] = theDC.get_Zt();
+			base[COL_ITH * stride + i] = theDC.get_Ith();
+
+			derived = false;
+		}
+		else {
+			std::string reason = "Error: device_population::set_device(int i, ...)\n";
+			reason += "Device index " + template_funcs::toString(i) + " is out of range\n";
+			throw std::runtime_error(reason);
+		}
+	}
+	catch (std::runtime_error &e) {
+		std::cerr << e.what();
+	}
+}
+
+int device_population::validate()
+{
+	// Check the parameters of every device in the population in a single pass
+	// The same conditions are applied as in ec_laser::set_params and the set_params of the parameter classes
+	// Result for each device is stored in the valid column as 1.0 or 0.0, number of invalid devices is returned
+	// Only one error message is written for the whole population
+
+	int n_bad = 0;
+
+	try {
+		const double *eta = col_ptr(COL_ETA); const double *etai = col_ptr(COL_ETAI);
+		const double *L = col_ptr(COL_L); const double *Lg = col_ptr(COL_LGOUT);
+		const double *Rg = col_ptr(COL_RG); const double *Rr = col_ptr(COL_RR);
+		const double *alpha = col_ptr(COL_ALPHA); const double *alphag = col_ptr(COL_ALPHAG);
+		const double *ZT = col_ptr(COL_ZT); const double *Ith = col_ptr(COL_ITH);
+		double *valid = col_ptr(COL_VALID);
+
+		for (int i = 0; i < n_dev; i++) {
+			bool ok = (eta[i] > 0.0) & (eta[i] < 1.1) & (etai[i] > 0.0) & (etai[i] < 1.1);
+			ok = ok & (L[i] > 0.0) & (Lg[i] > 0.0) & (Rg[i] > 0.0) & (Rr[i] > 0.0);
+			ok = ok & (alpha[i] > 0.0) & (alphag[i] > 0.0) & (ZT[i] > 0.0) & (Ith[i] > 0.0);
+
+			valid[i] = ok ? 1.0 : 0.0;
+			n_bad += ok ? 0 : 1;
+		}
+
+		if (n_bad > 0) {
+			std::string reason = "Error: device_population::validate()\n";
+			reason += template_funcs::toString(n_bad) + " of " + template_funcs::toString(n_dev) + " devices are not correctly defined\n";
+			throw std::runtime_error(reason);
+		}
+	}
+	catch (std::runtime_error &e) {
+		std::cerr << e.what();
+	}
+
+	return n_bad;
+}
+
+void device_population::compute_derived()
+{
+	// Compute RQfactor and etaext for every device in the population
+	// Formulae are those used in ec_laser::set_params
+	// Devices that fail validation are assigned RQfactor = etaext = 0 so that they produce no output power
+
+	validate();
+
+	const double *eta = col_ptr(COL_ETA); const double *etai = col_ptr(COL_ETAI);
+	const double *L = col_ptr(COL_L); const double *Lg = col_ptr(COL_LGOUT);
+	const double *Rg = col_ptr(COL_RG); const double *Rr = col_ptr(COL_RR);
+	const double *alpha = col_ptr(COL_ALPHA); const double *alphag = col_ptr(COL_ALPHAG);
+	const double *valid = col_ptr(COL_VALID);
+	double *RQ = col_ptr(COL_RQFACTOR);
+	double *etaext = col_ptr(COL_ETAEXT);
+
+	for (int i = 0; i < n_dev; i++) {
+		if (valid[i] > 0.0) {
+			double Reff = eta[i] * eta[i] * Rg[i];
+			double Rprime = 1.0 - Rg[i];
+			double Rprod = log(1.0 / (Rr[i] * Reff));
+			double etad = Rprod / (Rprod + (2.0 * L[i] * alpha[i]));
+			double rtRr = sqrt(Rr[i]);
+
+			etaext[i] = etad * etai[i] * exp(alphag[i] * Lg[i]);
+
+			RQ[i] = (etaext[i] * eta[i] * Rprime * rtRr) / ((1.0 - Reff)*rtRr + (1.0 - Rr[i])*sqrt(Reff));
+		}
+		else {
+			etaext[i] = RQ[i] = 0.0;
+		}
+	}
+
+	derived = true;
+}
+
+void device_population::Pout(double wavelength, double current, std::vector<double> &out)
+{
+	// Compute Pout for every device in the population at the same current
+	// wavelength must be in units of nm
+	// out is resized to the number of devices
+
+	if (!derived) compute_derived();
+
+	out.resize(n_dev);
+
+	if (current > 0.0 && wavelength > 1000.0) {
+		const double hc = 1242.38 / wavelength;
+		const double *RQ = col_ptr(COL_RQFACTOR);
+		const double *Ith = col_ptr(COL_ITH);
+		double *res = out.data();
+
+		for (int i = 0; i < n_dev; i++) {
+			res[i] = RQ[i] * hc * (current - Ith[i]);
+		}
+	}
+	else {
+		std::fill(out.begin(), out.end(), 0.0);
+	}
+}
+
+void device_population::Pout(double wavelength, std::vector<double> &current, std::vector<double> &out)
+{
+	// Compute Pout for every device in the population, device i is driven at current[i]
+	// wavelength must be in units of nm
+
+	try {
+		if (static_cast<int>(current.size()) == n_dev) {
+			out.resize(n_dev);
+			Pout(wavelength, current.data(), out.data());
+		}
+		else {
+			std::string reason = "Error: device_population::Pout(double wavelength, std::vector<double> &current, std::vector<double> &out)\n";
+			reason += "Number of currents does not match number of devices\n";
+			throw std::runtime_error(reason);
+		}
+	}
+	catch (std::runtime_error &e) {
+		std::cerr << e.what();
+	}
+}
+
+void device_population::Pout(double wavelength, const double *current, double *out)
+{
+	// Compute Pout for every device in the population, device i is driven at current[i]
+	// current and out must each hold at least size() elements
+	// wavelength must be in units of nm
+
+	if (!derived) compute_derived();
+
+	const double *RQ = col_ptr(COL_RQFACTOR);
+	const double *Ith = col_ptr(COL_ITH);
+
+	if (wavelength > 1000.0) {
+		const double hc = 1242.38 / wavelength;
+
+		for (int i = 0; i < n_dev; i++) {
+			out[i] = current[i] > 0.0 ? RQ[i] * hc * (current[i] - Ith[i]) : 0.0;
+		}
+	}
+	else {
+		std::fill(out, out + n_dev, 0.0);
+	}
+}
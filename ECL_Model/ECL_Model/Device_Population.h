@@ -0,0 +1,74 @@
+#ifndef DEVICE_POPULATION_H
+#define DEVICE_POPULATION_H
+
+// Declaration of the class device_population
+// class will be used to store the parameters of a large number of External Cavity Lasers
+// Parameters are stored column-wise, one column per parameter, rather than as an array of ec_laser objects
+// All columns are carved out of a single block of memory and each column starts on a 64 byte boundary
+// so that loops over a whole population run through contiguous memory
+// The model for an ECL LI curve is described in the paper
+// Power-efficient {III-V/Silicon} external cavity {DBR} lasers, Zilkie et al, Opt. Expr., 20 (21), 2012
+
+// Column indices for the population arena
+enum pop_column { COL_ETA, COL_ETAI, COL_L, COL_LGOUT, COL_RG, COL_RR, COL_ALPHA, COL_ALPHAG, COL_ZT, COL_ITH, COL_RQFACTOR, COL_ETAEXT, COL_VALID, N_POP_COLS };
+
+class device_population {
+public:
+	device_population();
+	device_population(int n_devices);
+	device_population(const device_population &dp);
+
+	device_population& operator=(const device_population &dp);
+
+	void reserve(int n_devices);
+	void resize(int n_devices);
+	void clear();
+
+	int add_device(double coupEff, double intQE, lengths &theLength, reflections &theRefs, losses &theLoss, dcvals &theDC);
+
+	void set_device(int i, double coupEff, double intQE, lengths &theLength, reflections &theRefs, losses &theLoss, dcvals &theDC);
+
+	int validate();
+
+	void compute_derived();
+
+	void Pout(double wavelength, double current, std::vector<double> &out);
+
+	void Pout(double wavelength, std::vector<double> &current, std::vector<double> &out);
+
+	void Pout(double wavelength, const double *current, double *out);
+
+	// getters
+	inline int size() { return n_dev; }
+	inline int capacity() { return n_cap; }
+	inline bool derived_ready() { return derived; }
+
+	// column() gives write access to a whole column, the population cannot see writes made through the pointer
+	// so invalidate() must be called after writing and before the next call to Pout or compute_derived
+	// use read_column() when the column is only being read
+	inline double* column(pop_column col) { derived = false; return base + col * stride; }
+	inline void invalidate() { derived = false; }
+	inline const double* read_column(pop_column col) const { return base + col * stride; }
+	inline double get(pop_column col, int i) { return base[col * stride + i]; }
+	inline void set(pop_column col, int i, double val) { base[col * stride + i] = val; derived = false; }
+
+private:
+	void allocate(int n_devices, bool keep);
+
+	inline double* col_ptr(pop_column col) { return base + col * stride; }
+
+private:
+	static const int ALIGN_DOUBLES = 8; // 64 byte alignment for each column
+
+	int n_dev; // number of devices stored in the population
+	int n_cap; // number of devices that can be stored without re-allocating
+	int stride; // distance in doubles between the start of consecutive columns
+
+	bool derived; // RQfactor, etaext and valid columns are up to date
+
+	double *base; // aligned start of the first column in the arena
+
+	std::vector<double> arena; // single block of memory holding every column
+};
+
+#endif
@@ -0,0 +1,197 @@
+#ifndef ATTACH_H
+#include "Attach.h"
+#endif
+
+#include "ECL_C_API.h"
+
+// Definitions of the functions in the C interface to the ECL LI curve model
+// No C++ exception is allowed to pass back through the interface and nothing is written to the console,
+// errors are returned as ecl_status codes
+
+struct ecl_laser {
+	// ec_laser::Pout does not change the state of the laser, it is only non-const because of how it is declared
+	mutable ec_laser las;
+};
+
+namespace {
+
+	bool stride_ok(ptrdiff_t stride)
+	{
+		// byte strides must address whole doubles
+		return stride % static_cast<ptrdiff_t>(sizeof(double)) == 0;
+	}
+
+	ptrdiff_t elems(ptrdiff_t stride)
+	{
+		// convert a byte stride to a stride in doubles
+		return stride / static_cast<ptrdiff_t>(sizeof(double));
+	}
+
+	void parallel_range(size_t n, int n_threads, size_t min_chunk, std::function<void(size_t, size_t)> work)
+	{
+		// split [0, n) into contiguous chunks of at least min_chunk elements and process each chunk on its own thread
+		// the calling thread processes the last chunk
+		// if a thread cannot be started the calling thread also processes the chunks that were not given a thread,
+		// so the threads already running are always joined and no exception escapes
+
+		size_t n_max = n_threads > 0 ? static_cast<size_t>(n_threads) : std::max(1u, std::thread::hardware_concurrency());
+		size_t n_use = std::max(static_cast<size_t>(1), std::min(n_max, n / std::max(min_chunk, static_cast<size_t>(1))));
+		size_t chunk = (n + n_use - 1) / n_use;
+
+		// reserving first means push_back cannot throw once a thread has been created
+		std::vector<std::thread> workers;
+		workers.reserve(n_use);
+
+		size_t t = 0;
+		for (; t + 1 < n_use; t++) {
+			try {
+				workers.push_back( std::thread(work, t * chunk, std::min(n, (t + 1) * chunk)) );
+			}
+			catch (std::system_error &) {
+				break;
+			}
+		}
+
+		work( std::min(n, t * chunk), n );
+
+		for (size_t t = 0; t < workers.size(); t++) workers[t].join();
+	}
+
+	const size_t POUT_CHUNK = 65536; // smallest number of currents worth giving to a thread
+}
+
+int ecl_api_version(void)
+{
+	return ECL_API_VERSION;
+}
+
+ecl_status ecl_create(double coupEff, double intQE, double L, double Lgout, double Rg, double Rr, double alpha, double alphag, double ZT, double Ith, ecl_laser **las)
+{
+	// The parameter checks are those made by ec_laser::set_params and the set_params of the parameter classes
+	// they are made here so that an invalid parameter can be reported to the caller
+
+	if (las == nullptr) return ECL_ERR_NULL;
+
+	*las = nullptr;
+
+	bool c1 = coupEff > 0.0 && coupEff < 1.1 && intQE > 0.0 && intQE < 1.1;
+	bool c2 = L > 0.0 && Lgout > 0.0 && Rg > 0.0 && Rr > 0.0;
+	bool c3 = alpha > 0.0 && alphag > 0.0 && ZT > 0.0 && Ith > 0.0;
+
+	if (!(c1 && c2 && c3)) return ECL_ERR_PARAM;
+
+	try {
+		lengths theLength(L, Lgout);
+		reflections theRefs(Rg, Rr);
+		losses theLoss(alpha, alphag);
+		dcvals theDC(ZT, Ith);
+
+		ecl_laser *res = new ecl_laser();
+		res->las.set_params(coupEff, intQE, theLength, theRefs, theLoss, theDC);
+
+		*las = res;
+
+		return ECL_OK;
+	}
+	catch (std::exception &) {
+		return ECL_ERR_ALLOC;
+	}
+}
+
+void ecl_destroy(ecl_laser *las)
+{
+	delete las;
+}
+
+ecl_status ecl_pout(const ecl_laser *las, double wavelength, const double *current, ptrdiff_t current_stride, double *pout, ptrdiff_t pout_stride, size_t n, int n_threads)
+{
+	// pout[i] = Pout(wavelength, current[i]) computed in place on the caller's buffers
+
+	if (las == nullptr || ((current == nullptr || pout == nullptr) && n > 0)) return ECL_ERR_NULL;
+
+	if (!stride_ok(current_stride) || !stride_ok(pout_stride) || pout_stride == 0) return ECL_ERR_STRIDE;
+
+	ptrdiff_t cs = elems(current_stride), ps = elems(pout_stride);
+
+	try {
+		parallel_range(n, n_threads, POUT_CHUNK, [=](size_t start, size_t end) {
+			for (size_t i = start; i < end; i++) {
+				pout[static_cast<ptrdiff_t>(i) * ps] = las->las.Pout(wavelength, current[static_cast<ptrdiff_t>(i) * cs]);
+			}
+		});
+
+		return ECL_OK;
+	}
+	catch (std::exception &) {
+		return ECL_ERR_ALLOC;
+	}
+}
+
+ecl_status ecl_pout_thermal(const ecl_laser *las, double wavelength, double T, double gamma, double T0, double T1, const double *current, ptrdiff_t current_stride, double *pout, ptrdiff_t pout_stride, size_t n, int n_threads)
+{
+	// pout[i] = Pout(wavelength, current[i], T, gamma, aa, T0, T1) computed in place on the caller's buffers
+	// aa is not used by ec_laser::Pout and is not part of the interface
+
+	if (las == nullptr || ((current == nullptr || pout == nullptr) && n > 0)) return ECL_ERR_NULL;
+
+	if (!stride_ok(current_stride) || !stride_ok(pout_stride) || pout_stride == 0) return ECL_ERR_STRIDE;
+
+	ptrdiff_t cs = elems(current_stride), ps = elems(pout_stride);
+
+	try {
+		parallel_range(n, n_threads, POUT_CHUNK, [=](size_t start, size_t end) {
+			for (size_t i = start; i < end; i++) {
+				pout[static_cast<ptrdiff_t>(i) * ps] = las->las.Pout(wavelength, current[static_cast<ptrdiff_t>(i) * cs], T, gamma, 0.0, T0, T1);
+			}
+		});
+
+		return ECL_OK;
+	}
+	catch (std::exception &) {
+		return ECL_ERR_ALLOC;
+	}
+}
+
+ecl_status ecl_fit_li(const double *current, ptrdiff_t current_row_stride, ptrdiff_t current_col_stride, const double *power, ptrdiff_t power_row_stride, ptrdiff_t power_col_stride, size_t n_curves, size_t n_pts, double wavelength, double fit_frac, ecl_fit_result *results, int n_threads)
+{
+	// fit each curve with li_workflow::fit_li_core, reading the caller's buffers in place
+
+	if ((current == nullptr || power == nullptr || results == nullptr) && n_curves > 0) return ECL_ERR_NULL;
+
+	if (!stride_ok(current_row_stride) || !stride_ok(current_col_stride) || !stride_ok(power_row_stride) || !stride_ok(power_col_stride)) return ECL_ERR_STRIDE;
+
+	// li_workflow::fit_li_core counts points with an int
+	if (n_pts > static_cast<size_t>(std::numeric_limits<int>::max())) return ECL_ERR_PARAM;
+
+	ptrdiff_t crs = elems(current_row_stride), ccs = elems(current_col_stride);
+	ptrdiff_t prs = elems(power_row_stride), pcs = elems(power_col_stride);
+
+	try {
+		std::atomic<int> n_bad(0);
+
+		// fitting a curve costs about four Pout evaluations per point
+		size_t min_curves = std::max(static_cast<size_t>(1), POUT_CHUNK / (4 * std::max(n_pts, static_cast<size_t>(1))));
+
+		parallel_range(n_curves, n_threads, min_curves, [&](size_t start, size_t end) {
+			for (size_t i = start; i < end; i++) {
+				li_workflow::li_fit fit;
+
+				li_workflow::fit_li_core(current + static_cast<ptrdiff_t>(i) * crs, ccs, power + static_cast<ptrdiff_t>(i) * prs, pcs, static_cast<int>(n_pts), wavelength, fit_frac, fit);
+
+				results[i].slope = fit.slope;
+				results[i].Ith = fit.Ith;
+				results[i].RQfactor = fit.RQfactor;
+				results[i].rms_fit = fit.rms_fit;
+				results[i].n_fit = fit.n_fit;
+				results[i].ok = fit.ok ? 1 : 0;
+
+				if (!fit.ok) n_bad++;
+			}
+		});
+
+		return n_bad.load() > 0 ? ECL_ERR_FIT : ECL_OK;
+	}
+	catch (std::exception &) {
+		return ECL_ERR_ALLOC;
+	}
+}
@@ -0,0 +1,92 @@
+#ifndef ECL_C_API_H
+#define ECL_C_API_H
+
+/*
+ C interface to the ECL LI curve model, for use from Python (ctypes / cffi), LabVIEW and other languages
+ The model for an ECL LI curve is described in the paper
+ Power-efficient {III-V/Silicon} external cavity {DBR} lasers, Zilkie et al, Opt. Expr., 20 (21), 2012
+
+ Conventions
+ - every function returns an ecl_status code, results are written to caller-owned memory
+ - arrays are described by a pointer and a stride in bytes, as for a NumPy array, so non-contiguous views can be passed without copying
+ - for input arrays a stride of zero repeats the same element, e.g. one current array shared by every curve in ecl_fit_li
+ - output arrays must not have a stride of zero, ECL_ERR_STRIDE is returned
+ - the library never returns memory that the caller must free, ecl_laser handles are released with ecl_destroy
+ - a handle is not modified after ecl_create, so any number of threads may use the same handle at the same time
+ - n_threads = 0 uses all available hardware threads, n_threads = 1 runs on the calling thread
+*/
+
+#include <stddef.h>
+
+/* ECL_C_API_STATIC is defined when the interface is compiled into a program rather than built as a library, as in the ECL_Model test program */
+#if defined(ECL_C_API_STATIC)
+	#define ECL_API
+#elif defined(_WIN32)
+	#if defined(ECL_C_API_EXPORTS)
+		#define ECL_API __declspec(dllexport)
+	#else
+		#define ECL_API __declspec(dllimport)
+	#endif
+#else
+	#define ECL_API __attribute__((visibility("default")))
+#endif
+
+#define ECL_API_VERSION 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum ecl_status {
+	ECL_OK = 0,
+	ECL_ERR_NULL = 1, /* a required pointer argument is null */
+	ECL_ERR_PARAM = 2, /* a laser parameter or an array size is out of range */
+	ECL_ERR_STRIDE = 3, /* a stride is not a multiple of sizeof(double), or an output stride is zero */
+	ECL_ERR_FIT = 4, /* at least one curve could not be fitted */
+	ECL_ERR_ALLOC = 5 /* the library could not allocate memory */
+} ecl_status;
+
+/* Opaque handle to a laser */
+typedef struct ecl_laser ecl_laser;
+
+/* Result of fitting Pout = slope ( I - Ith ) to a measured LI curve */
+typedef struct ecl_fit_result {
+	double slope; /* slope efficiency */
+	double Ith; /* threshold current */
+	double RQfactor; /* RQfactor implied by slope at the given wavelength */
+	double rms_fit; /* rms deviation of the measured data from the fitted line */
+	int n_fit; /* number of points used in the fit */
+	int ok; /* 1 if the curve was fitted, 0 otherwise */
+} ecl_fit_result;
+
+ECL_API int ecl_api_version(void);
+
+/* Create a laser from the parameters of the lengths, reflections, losses and dcvals classes
+ coupEff, intQE: waveguide coupling efficiency and internal quantum efficiency, 0 < value < 1.1
+ L, Lgout: laser cavity length and length of grating outside cavity
+ Rg, Rr: peak grating reflectance and RSOA rear facet reflectance
+ alpha, alphag: waveguide scattering loss and grating loss
+ ZT, Ith: laser thermal impedance and threshold current
+ all of L, Lgout, Rg, Rr, alpha, alphag, ZT, Ith must be positive */
+ECL_API ecl_status ecl_create(double coupEff, double intQE, double L, double Lgout, double Rg, double Rr, double alpha, double alphag, double ZT, double Ith, ecl_laser **las);
+
+ECL_API void ecl_destroy(ecl_laser *las);
+
+/* Pout for n currents, pout[i] = Pout(wavelength, current[i]), wavelength in nm */
+ECL_API ecl_status ecl_pout(const ecl_laser *las, double wavelength, const double *current, ptrdiff_t current_stride, double *pout, ptrdiff_t pout_stride, size_t n, int n_threads);
+
+/* Pout including thermal roll-off for n currents, see ec_laser::Pout(wavelength, current, T, gamma, aa, T0, T1) */
+ECL_API ecl_status ecl_pout_thermal(const ecl_laser *las, double wavelength, double T, double gamma, double T0, double T1, const double *current, ptrdiff_t current_stride, double *pout, ptrdiff_t pout_stride, size_t n, int n_threads);
+
+/* Fit Pout = slope ( I - Ith ) to n_curves measured LI curves of n_pts points each
+ point j of curve i is current[i * current_row_stride + j * current_col_stride], likewise for power
+ only points with power above fit_frac * max power of the curve are used in the fit
+ results must hold n_curves elements, ECL_ERR_FIT is returned if any curve could not be fitted
+ n_pts may not exceed INT_MAX, ECL_ERR_PARAM is returned otherwise */
+ECL_API ecl_status ecl_fit_li(const double *current, ptrdiff_t current_row_stride, ptrdiff_t current_col_stride, const double *power, ptrdiff_t power_row_stride, ptrdiff_t power_col_stride, size_t n_curves, size_t n_pts, double wavelength, double fit_frac, ecl_fit_result *results, int n_threads);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,233 @@
+#ifndef ATTACH_H
+#include "Attach.h"
+#endif
+
+// Definitions of the functions in the li_workflow namespace
+// Pipeline for reading, fitting and writing a batch of measured LI curves
+
+bool li_workflow::ingest(li_record &rec)
+{
+	// read an LI file and split it into current and power columns
+
+	try {
+		std::vector<double> data;
+		int n_pts = 0;
+
+		// read_into_vector would exit the program from this worker thread if the file cannot be opened
+		if (!useful_funcs::try_read_into_vector(rec.fit.filename, data, n_pts)) {
+			std::string reason = "Error: li_workflow::ingest(li_record &rec)\n";
+			reason += "Cannot open: " + rec.fit.filename + "\n";
+			throw std::runtime_error(reason);
+		}
+
+		if (n_pts > 1 && n_pts % 2 == 0) {
+			int n = n_pts / 2;
+
+			rec.current.resize(n);
+			rec.power.resize(n);
+
+			for (int i = 0; i < n; i++) {
+				rec.current[i] = data[2 * i];
+				rec.power[i] = data[2 * i + 1];
+			}
+
+			rec.fit.n_pts = n;
+
+			return true;
+		}
+		else {
+			std::string reason = "Error: li_workflow::ingest(li_record &rec)\n";
+			reason += rec.fit.filename + " does not contain two columns of data\n";
+			throw std::runtime_error(reason);
+		}
+	}
+	catch (std::runtime_error &e) {
+		std::cerr << e.what();
+		rec.fit.ok = false;
+		return true; // pass the record on so that the failure appears in the results
+	}
+}
+
+bool li_workflow::fit_li(std::vector<double> &current, std::vector<double> &power, double wavelength, double fit_frac, li_fit &res)
+{
+	// Least squares fit of Pout = S ( I - Ith ) to a measured LI curve stored in vectors
+
+	int n = static_cast<int>(std::min(current.size(), power.size()));
+
+	return fit_li(current.data(), 1, power.data(), 1, n, wavelength, fit_frac, res);
+}
+
+bool li_workflow::fit_li(const double *current, std::ptrdiff_t cstride, const double *power, std::ptrdiff_t pstride, int n, double wavelength, double fit_frac, li_fit &res)
+{
+	// Least squares fit of Pout = S ( I - Ith ) to a measured LI curve, see fit_li_core
+	// an error message is written if the curve cannot be fitted
+
+	try {
+		if (fit_li_core(current, cstride, power, pstride, n, wavelength, fit_frac, res)) {
+			return true;
+		}
+		else {
+			std::string reason = "Error: li_workflow::fit_li(const double *current, std::ptrdiff_t cstride, const double *power, std::ptrdiff_t pstride, int n, double wavelength, double fit_frac, li_fit &res)\n";
+			reason += "Insufficient data above threshold to fit " + res.filename + "\n";
+			throw std::runtime_error(reason);
+		}
+	}
+	catch (std::runtime_error &e) {
+		std::cerr << e.what();
+		return false;
+	}
+}
+
+bool li_workflow::fit_li_core(const double *current, std::ptrdiff_t cstride, const double *power, std::ptrdiff_t pstride, int n, double wavelength, double fit_frac, li_fit &res)
+{
+	// Least squares fit of Pout = S ( I - Ith ) to the lasing part of a measured LI curve
+	// only points with power above fit_frac * max power are used, this excludes the sub-threshold region
+	// RQfactor is computed from S using the same photon energy factor as ec_laser::Pout
+	// wavelength must be in units of nm
+	// current[i * cstride] and power[i * pstride] are the i^{th} measured point, data is read in place
+	// Nothing is written to the console, failure is reported by the return value and res.ok
+
+	double Pmax = 0.0;
+	for (int i = 0; i < n; i++) Pmax = std::max(Pmax, power[i * pstride]);
+
+	double Pcut = fit_frac * Pmax;
+	double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+	int m = 0;
+
+	for (int i = 0; i < n; i++) {
+		if (current[i * cstride] > 0.0 && power[i * pstride] > Pcut) {
+			sx += current[i * cstride]; sy += power[i * pstride];
+			sxx += current[i * cstride] * current[i * cstride]; sxy += current[i * cstride] * power[i * pstride];
+			m++;
+		}
+	}
+
+	double denom = m * sxx - sx * sx;
+
+	if (m > 1 && fabs(denom) > EPS && wavelength > 1000.0) {
+		double S = (m * sxy - sx * sy) / denom;
+		double b = (sy - S * sx) / m;
+
+		res.n_fit = m;
+		res.slope = S;
+		res.Ith = fabs(S) > EPS ? -b / S : 0.0;
+		res.RQfactor = S * wavelength / 1242.38;
+
+		double sum = 0.0;
+		for (int i = 0; i < n; i++) {
+			if (current[i * cstride] > 0.0 && power[i * pstride] > Pcut) sum += template_funcs::DSQR(power[i * pstride] - (S * current[i * cstride] + b));
+		}
+		res.rms_fit = sqrt(sum / m);
+		res.ok = true;
+	}
+	else {
+		res.ok = false;
+	}
+
+	return res.ok;
+}
+
+bool li_workflow::fit(li_record &rec, ec_laser &nominal, li_settings &opts)
+{
+	// fit the model to the measured data and compare the measured data with the nominal laser
+
+	if (rec.fit.n_pts > 0) {
+		fit_li(rec.current, rec.power, opts.wavelength, opts.fit_frac, rec.fit);
+
+		double sum = 0.0;
+		for (int i = 0; i < rec.fit.n_pts; i++) {
+			sum += template_funcs::DSQR(rec.power[i] - nominal.Pout(opts.wavelength, rec.current[i]));
+		}
+		rec.fit.rms_nominal = sqrt(sum / rec.fit.n_pts);
+	}
+
+	return true;
+}
+
+std::string li_workflow::output_name(std::string &filename)
+{
+	// name of the file to which the fit results for filename are written
+	// LI_Dev_1.txt -> LI_Dev_1_Fit.txt
+
+	size_t pos = filename.find_last_of('.');
+	size_t sep = filename.find_last_of("/\\");
+
+	if (pos != std::string::npos && (sep == std::string::npos || pos > sep)) {
+		return filename.substr(0, pos) + "_Fit" + filename.substr(pos);
+	}
+	else {
+		return filename + "_Fit.txt";
+	}
+}
+
+void li_workflow::report(li_record &rec, ec_laser &nominal, li_settings &opts)
+{
+	// write the measured data, the fitted model and the nominal model to file
+
+	if (rec.fit.ok) {
+		std::string name = output_name(rec.fit.filename);
+
+		std::ofstream write(name, std::ios_base::out | std::ios_base::trunc);
+
+		if (write.is_open()) {
+			write << std::setprecision(10);
+
+			for (int i = 0; i < rec.fit.n_pts; i++) {
+				double Pfit = std::max(0.0, rec.fit.slope * (rec.current[i] - rec.fit.Ith));
+				write << rec.current[i] << " , " << rec.power[i] << " , " << Pfit << " , " << nominal.Pout(opts.wavelength, rec.current[i]) << "\n";
+			}
+
+			write.close();
+		}
+		else {
+			std::cerr << "Error: li_workflow::report(li_record &rec, ec_laser &nominal, li_settings &opts)\nCannot open: " + name + "\n";
+		}
+	}
+}
+
+void li_workflow::run(std::vector<std::string> &filenames, ec_laser &nominal, li_settings &opts, std::vector<li_fit> &results, bool loud)
+{
+	// Process a list of LI files as a three stage pipeline: read -> fit -> write
+	// Each stage runs on its own threads and the stages are joined by bounded queues
+	// When a queue is full the stage feeding it waits, so at most queue_size records are held between any two stages
+	// results[i] holds the fit for filenames[i], failed files have results[i].ok = false
+	// ec_laser::Pout does not modify the laser so nominal is shared by all fitting and writing threads
+
+	int n_files = static_cast<int>(filenames.size());
+
+	results.assign(n_files, li_fit());
+
+	pipeline::bounded_queue<li_record> q_files(opts.queue_size);
+	pipeline::bounded_queue<li_record> q_read(opts.queue_size);
+	pipeline::bounded_queue<li_record> q_fitted(opts.queue_size);
+
+	pipeline::stage<li_record, li_record> reader(q_files, q_read, opts.n_read,
+		[](li_record &in, li_record &out) { bool keep = ingest(in); out = std::move(in); return keep; });
+
+	pipeline::stage<li_record, li_record> fitter(q_read, q_fitted, opts.n_fit,
+		[&nominal, &opts](li_record &in, li_record &out) { bool keep = fit(in, nominal, opts); out = std::move(in); return keep; });
+
+	// each record has a distinct index so the writers can store results without locking
+	pipeline::sink_stage<li_record> writer(q_fitted, opts.n_write,
+		[&nominal, &opts, &results](li_record &in) { report(in, nominal, opts); results[in.index] = in.fit; });
+
+	reader.start(); fitter.start(); writer.start();
+
+	// the calling thread feeds the first queue
+	q_files.add_producers(1);
+	for (int i = 0; i < n_files; i++) {
+		li_record rec;
+		rec.index = i;
+		rec.fit.filename = filenames[i];
+		q_files.push(rec);
+	}
+	q_files.producer_done();
+
+	reader.join(); fitter.join(); writer.join();
+
+	if (loud) {
+		int n_ok = 0;
+		for (int i = 0; i < n_files; i++) if (results[i].ok) n_ok++;
+		std::cout << template_funcs::toString(n_ok) << " of " << template_funcs::toString(n_files) << " LI files processed\n";
+	}
+}
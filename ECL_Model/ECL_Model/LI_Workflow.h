@@ -0,0 +1,66 @@
+#ifndef LI_WORKFLOW_H
+#define LI_WORKFLOW_H
+
+// Namespace containing functions for processing a batch of measured LI curves
+// Each file is read, the ECL model is fitted to the measured data and the result is written to file
+// The three steps are run as a pipeline so that file reading, fitting and writing overlap in time
+// A file that cannot be opened or read is reported in the results and does not stop the other files
+// Each LI file is expected to contain two columns: current and output power, in the units used by ec_laser::Pout
+
+namespace li_workflow {
+
+	// Result of fitting the ECL model Pout = S ( I - Ith ) to a measured LI curve
+	struct li_fit {
+		li_fit() : n_pts(0), n_fit(0), slope(0.0), Ith(0.0), RQfactor(0.0), rms_fit(0.0), rms_nominal(0.0), ok(false) {}
+
+		std::string filename;
+		int n_pts; // number of measured points
+		int n_fit; // number of points used in the fit
+		double slope; // slope efficiency S
+		double Ith; // threshold current
+		double RQfactor; // RQfactor implied by slope at the given wavelength
+		double rms_fit; // rms deviation of the measured data from the fitted line
+		double rms_nominal; // rms deviation of the measured data from the nominal ec_laser
+		bool ok; // file was read and fitted successfully
+	};
+
+	// Data passed between the stages of the pipeline
+	struct li_record {
+		li_record() : index(0) {}
+
+		int index; // position of the file in the input list
+		std::vector<double> current;
+		std::vector<double> power;
+		li_fit fit;
+	};
+
+	// Parameters for the pipeline
+	struct li_settings {
+		li_settings() : n_read(2), n_fit(2), n_write(2), queue_size(16), wavelength(1550.0), fit_frac(0.2) {}
+
+		int n_read; // number of threads reading files
+		int n_fit; // number of threads fitting data
+		int n_write; // number of threads writing results
+		int queue_size; // number of records that can wait between two stages
+		double wavelength; // lasing wavelength in nm
+		double fit_frac; // only points with power above fit_frac * max power are used in the fit
+	};
+
+	bool ingest(li_record &rec);
+
+	bool fit_li(std::vector<double> &current, std::vector<double> &power, double wavelength, double fit_frac, li_fit &res);
+
+	bool fit_li(const double *current, std::ptrdiff_t cstride, const double *power, std::ptrdiff_t pstride, int n, double wavelength, double fit_frac, li_fit &res);
+
+	bool fit_li_core(const double *current, std::ptrdiff_t cstride, const double *power, std::ptrdiff_t pstride, int n, double wavelength, double fit_frac, li_fit &res);
+
+	bool fit(li_record &rec, ec_laser &nominal, li_settings &opts);
+
+	void report(li_record &rec, ec_laser &nominal, li_settings &opts);
+
+	std::string output_name(std::string &filename);
+
+	void run(std::vector<std::string> &filenames, ec_laser &nominal, li_settings &opts, std::vector<li_fit> &results, bool loud = false);
+}
+
+#endif
@@ -8,8 +8,23 @@
 
 int main()
 {
+	testing::device_population_ec_laser(); 
 
-	
+	testing::device_population_column_write(); 
+
+	testing::pipeline_exactly_once(); 
+
+	testing::li_workflow_missing_file(); 
+
+	testing::c_api_strides(); 
+
+	testing::data_prep_co_sort(); 
+
+	testing::data_prep_dedupe_resample(); 
+
+	testing::sobol_sequence_reference(); 
+
+	testing::sobol_indices_analytic(); 
 
 	std::cout << "Press return to close\n";
 	std::cin.get(); 
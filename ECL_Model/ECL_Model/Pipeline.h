@@ -0,0 +1,273 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+// Template classes for building multi-stage processing pipelines
+// Each stage runs on its own pool of worker threads and the stages are connected by bounded queues
+// A full queue blocks the stage feeding it, so throughput is limited by the slowest stage rather than the sum of the stages
+// A thread that cannot push or pop spins briefly and then sleeps on a condition variable, so idle stages do not take CPU from busy ones
+// The queue is the bounded multi-producer multi-consumer queue described by D. Vyukov
+// http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+
+namespace pipeline {
+
+	template <class T> class bounded_queue {
+	public:
+		bounded_queue(int size = 64)
+		{
+			// capacity is rounded up to a power of two so that the cell index can be computed with a mask
+
+			size_t n = 2;
+			while (n < static_cast<size_t>(size)) n *= 2;
+
+			mask = n - 1;
+			cells.reset(new cell[n]);
+			for (size_t i = 0; i < n; i++) cells[i].seq.store(i, std::memory_order_relaxed);
+
+			head.store(0, std::memory_order_relaxed);
+			tail.store(0, std::memory_order_relaxed);
+			n_producers.store(0, std::memory_order_relaxed);
+			closed.store(false, std::memory_order_relaxed);
+			n_wait_push.store(0, std::memory_order_relaxed);
+			n_wait_pop.store(0, std::memory_order_relaxed);
+		}
+
+		bool try_push(T &item)
+		{
+			// attempt to place item on the queue without waiting, item is moved from on success
+
+			size_t pos = tail.load(std::memory_order_relaxed);
+			for (;;) {
+				cell *c = &cells[pos & mask];
+				size_t seq = c->seq.load(std::memory_order_acquire);
+				std::ptrdiff_t dif = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+				if (dif == 0) {
+					if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+						c->data = std::move(item);
+						c->seq.store(pos + 1, std::memory_order_release);
+						return true;
+					}
+				}
+				else if (dif < 0) {
+					return false; // queue is full
+				}
+				else {
+					pos = tail.load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+		bool try_pop(T &item)
+		{
+			// attempt to remove an item from the queue without waiting
+
+			size_t pos = head.load(std::memory_order_relaxed);
+			for (;;) {
+				cell *c = &cells[pos & mask];
+				size_t seq = c->seq.load(std::memory_order_acquire);
+				std::ptrdiff_t dif = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+				if (dif == 0) {
+					if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+						item = std::move(c->data);
+						c->seq.store(pos + mask + 1, std::memory_order_release);
+						return true;
+					}
+				}
+				else if (dif < 0) {
+					return false; // queue is empty
+				}
+				else {
+					pos = head.load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+		void push(T &item)
+		{
+			// place item on the queue, wait while the queue is full
+			// this is where back-pressure is applied to the stage feeding the queue
+
+			for (int i = 0; i < SPIN_LIMIT; i++) {
+				if (try_push(item)) { wake(n_wait_pop, not_empty); return; }
+				std::this_thread::yield();
+			}
+
+			{
+				// queue has stayed full, sleep until a consumer makes space
+				std::unique_lock<std::mutex> lock(mtx);
+				n_wait_push.fetch_add(1);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				while (!try_push(item)) not_full.wait(lock);
+				n_wait_push.fetch_sub(1);
+			}
+
+			wake(n_wait_pop, not_empty);
+		}
+
+		bool pop(T &item)
+		{
+			// remove an item from the queue, wait while the queue is empty
+			// returns false once the queue has been closed and everything on it has been consumed
+
+			for (int i = 0; i < SPIN_LIMIT; i++) {
+				if (try_pop(item)) { wake(n_wait_push, not_full); return true; }
+				if (closed.load(std::memory_order_acquire)) break;
+				std::this_thread::yield();
+			}
+
+			bool got = false;
+			{
+				// queue has stayed empty, sleep until a producer adds an item or the queue is closed
+				std::unique_lock<std::mutex> lock(mtx);
+				n_wait_pop.fetch_add(1);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				for (;;) {
+					if (try_pop(item)) { got = true; break; }
+					if (closed.load(std::memory_order_acquire)) { got = try_pop(item); break; }
+					not_empty.wait(lock);
+				}
+				n_wait_pop.fetch_sub(1);
+			}
+
+			if (got) wake(n_wait_push, not_full);
+
+			return got;
+		}
+
+		// Each thread that pushes onto the queue registers as a producer and calls producer_done when it is finished
+		// the queue is closed when the last producer is done
+		void add_producers(int n) { n_producers.fetch_add(n, std::memory_order_relaxed); }
+
+		void producer_done()
+		{
+			if (n_producers.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+				closed.store(true, std::memory_order_release);
+
+				// every sleeping consumer must wake to see that the queue is closed
+				{ std::lock_guard<std::mutex> lock(mtx); }
+				not_empty.notify_all();
+			}
+		}
+
+		inline int capacity() { return static_cast<int>(mask + 1); }
+
+	private:
+		struct cell {
+			std::atomic<size_t> seq;
+			T data;
+		};
+
+		bounded_queue(const bounded_queue &); // not copyable
+		bounded_queue& operator=(const bounded_queue &);
+
+		void wake(std::atomic<int> &n_wait, std::condition_variable &cv)
+		{
+			// wake one thread sleeping on cv, if there is one
+			// the fence pairs with the fence made by a thread before it sleeps: either that thread sees the change to the queue
+			// or this thread sees its n_wait count, and taking the lock means the notify cannot fall between its check and its wait
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (n_wait.load(std::memory_order_relaxed) > 0) {
+				{ std::lock_guard<std::mutex> lock(mtx); }
+				cv.notify_one();
+			}
+		}
+
+		static const int SPIN_LIMIT = 64; // attempts made before a thread goes to sleep
+
+	private:
+		size_t mask;
+		std::unique_ptr<cell[]> cells;
+
+		// head and tail are kept on separate cache lines so that producers and consumers do not contend
+		alignas(64) std::atomic<size_t> head;
+		alignas(64) std::atomic<size_t> tail;
+		alignas(64) std::atomic<int> n_producers;
+		std::atomic<bool> closed;
+
+		// slow path for threads that have to wait
+		std::atomic<int> n_wait_push; // number of threads sleeping until there is space
+		std::atomic<int> n_wait_pop; // number of threads sleeping until there is an item
+		std::mutex mtx;
+		std::condition_variable not_full;
+		std::condition_variable not_empty;
+	};
+
+	template <class In, class Out> class stage {
+	public:
+		// A stage pops items from in, applies work to each item and pushes the result onto out
+		// work returns false if the item should be dropped rather than passed on
+		// n_workers threads run the stage concurrently, so work must be safe to call from several threads
+
+		stage(bounded_queue<In> &in, bounded_queue<Out> &out, int n_workers, std::function<bool(In&, Out&)> work) : qin(in), qout(out), n_threads(std::max(1, n_workers)), func(work)
+		{
+			qout.add_producers(n_threads);
+		}
+
+		void start()
+		{
+			for (int i = 0; i < n_threads; i++) {
+				workers.push_back( std::thread(&stage::run, this) );
+			}
+		}
+
+		void join()
+		{
+			for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+			workers.clear();
+		}
+
+	private:
+		void run()
+		{
+			In item; Out res;
+			while (qin.pop(item)) {
+				if (func(item, res)) qout.push(res);
+			}
+			qout.producer_done();
+		}
+
+	private:
+		bounded_queue<In> &qin;
+		bounded_queue<Out> &qout;
+		int n_threads;
+		std::function<bool(In&, Out&)> func;
+		std::vector<std::thread> workers;
+	};
+
+	template <class In> class sink_stage {
+	public:
+		// Final stage of a pipeline, pops items from in and applies work to each item
+		// n_workers threads run the stage concurrently, so work must be safe to call from several threads
+
+		sink_stage(bounded_queue<In> &in, int n_workers, std::function<void(In&)> work) : qin(in), n_threads(std::max(1, n_workers)), func(work)
+		{
+		}
+
+		void start()
+		{
+			for (int i = 0; i < n_threads; i++) {
+				workers.push_back( std::thread(&sink_stage::run, this) );
+			}
+		}
+
+		void join()
+		{
+			for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+			workers.clear();
+		}
+
+	private:
+		void run()
+		{
+			In item;
+			while (qin.pop(item)) func(item);
+		}
+
+	private:
+		bounded_queue<In> &qin;
+		int n_threads;
+		std::function<void(In&)> func;
+		std::vector<std::thread> workers;
+	};
+}
+
+#endif
@@ -0,0 +1,374 @@
+#ifndef ATTACH_H
+#include "Attach.h"
+#endif
+
+// Definitions of the class sobol_sequence and the functions in the sensitivity namespace
+// Global sensitivity analysis of the ECL model output power with respect to the laser parameters
+
+namespace {
+
+	// Joe-Kuo direction numbers for dimensions 2 to 21, file new-joe-kuo-6.21201
+	// s is the degree of the primitive polynomial, a encodes its coefficients, m are the initial direction numbers
+	struct jk_entry {
+		int s, a;
+		unsigned int m[7];
+	};
+
+	const jk_entry JOE_KUO[] = {
+		{ 1, 0, { 1 } },
+		{ 2, 1, { 1, 3 } },
+		{ 3, 1, { 1, 3, 1 } },
+		{ 3, 2, { 1, 1, 1 } },
+		{ 4, 1, { 1, 1, 3, 3 } },
+		{ 4, 4, { 1, 3, 5, 13 } },
+		{ 5, 2, { 1, 1, 5, 5, 17 } },
+		{ 5, 4, { 1, 1, 5, 5, 5 } },
+		{ 5, 7, { 1, 1, 7, 11, 19 } },
+		{ 5, 11, { 1, 1, 5, 1, 1 } },
+		{ 5, 13, { 1, 1, 1, 3, 11 } },
+		{ 5, 14, { 1, 3, 5, 5, 31 } },
+		{ 6, 1, { 1, 3, 3, 9, 7, 49 } },
+		{ 6, 13, { 1, 1, 1, 15, 21, 21 } },
+		{ 6, 16, { 1, 3, 1, 13, 27, 49 } },
+		{ 6, 19, { 1, 1, 1, 15, 7, 5 } },
+		{ 6, 22, { 1, 3, 1, 15, 13, 25 } },
+		{ 6, 25, { 1, 1, 5, 5, 19, 61 } },
+		{ 7, 1, { 1, 3, 7, 11, 23, 15, 103 } },
+		{ 7, 4, { 1, 3, 7, 13, 13, 15, 69 } }
+	};
+}
+
+const int sobol_sequence::MAX_DIM;
+
+sobol_sequence::sobol_sequence()
+{
+	// Default constructor
+	dim = 0; idx = 0;
+}
+
+sobol_sequence::sobol_sequence(int dimension)
+{
+	dim = 0; idx = 0;
+
+	set_params(dimension);
+}
+
+void sobol_sequence::set_params(int dimension)
+{
+	// compute the direction numbers for each dimension
+	// v[d * BITS + k] = m_{k+1} 2^{BITS - 1 - k}, further m are generated by the recurrence defined by the primitive polynomial
+
+	try {
+		if (dimension > 0 && dimension <= MAX_DIM) {
+			dim = dimension;
+			idx = 0;
+
+			v.assign(dim * BITS, 0);
+			state.assign(dim, 0);
+
+			for (int k = 0; k < BITS; k++) v[k] = 1u << (BITS - 1 - k); // first dimension is the van der Corput sequence
+
+			for (int d = 1; d < dim; d++) {
+				const jk_entry &jk = JOE_KUO[d - 1];
+				unsigned int *vd = &v[d * BITS];
+
+				for (int k = 0; k < BITS; k++) {
+					if (k < jk.s) {
+						vd[k] = jk.m[k] << (BITS - 1 - k);
+					}
+					else {
+						vd[k] = vd[k - jk.s] ^ (vd[k - jk.s] >> jk.s);
+						for (int l = 1; l < jk.s; l++) {
+							if ((jk.a >> (jk.s - 1 - l)) & 1) vd[k] ^= vd[k - l];
+						}
+					}
+				}
+			}
+		}
+		else {
+			std::string reason = "Error: sobol_sequence::set_params(int dimension)\n";
+			reason += "Dimension must be between 1 and " + template_funcs::toString(MAX_DIM) + "\n";
+			throw std::runtime_error(reason);
+		}
+	}
+	catch (std::runtime_error &e) {
+		std::cerr << e.what();
+	}
+}
+
+void sobol_sequence::point(unsigned int index, double *x)
+{
+	// write point number index of the sequence into x[0 .. dim-1]
+	// subsequent calls to next() continue from index + 1, so a thread can start anywhere in the sequence
+
+	unsigned int gray = index ^ (index >> 1);
+
+	for (int d = 0; d < dim; d++) {
+		unsigned int s = 0;
+		for (int k = 0; k < BITS; k++) {
+			if ((gray >> k) & 1u) s ^= v[d * BITS + k];
+		}
+		state[d] = s;
+	}
+
+	idx = index;
+
+	next(x);
+}
+
+void sobol_sequence::next(double *x)
+{
+	// write the next point of the sequence into x[0 .. dim-1]
+	// successive points in Gray code order differ by a single direction number
+
+	const double scale = 1.0 / 4294967296.0; // 2^{-32}
+
+	for (int d = 0; d < dim; d++) x[d] = state[d] * scale;
+
+	int c = 0;
+	while ((idx >> c) & 1u) c++; // position of the lowest zero bit of idx
+
+	if (c < BITS) {
+		for (int d = 0; d < dim; d++) state[d] ^= v[d * BITS + c];
+	}
+
+	idx++;
+}
+
+namespace {
+
+	const int N_SUMS = 3 + 2 * sensitivity::N_PARAMS; // number of running sums kept for each bootstrap replicate
+
+	unsigned long long splitmix64(unsigned long long x)
+	{
+		// mixing function used to derive the bootstrap weights from the sample index
+		x += 0x9E3779B97F4A7C15ULL;
+		x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+		return x ^ (x >> 31);
+	}
+
+	int poisson1(unsigned long long h)
+	{
+		// Poisson(1) distributed integer from a random 64 bit value by inversion of the cumulative distribution
+		double u = (h >> 11) * (1.0 / 9007199254740992.0);
+		double p = exp(-1.0), cdf = p;
+		int k = 0;
+		while (u > cdf && k < 20) {
+			k++;
+			p /= k;
+			cdf += p;
+		}
+		return k;
+	}
+
+	double quantile(std::vector<double> &vals, double q)
+	{
+		// linearly interpolated quantile of vals, vals is sorted in place
+		std::sort(vals.begin(), vals.end());
+		double pos = q * (vals.size() - 1);
+		size_t i = static_cast<size_t>(pos);
+		if (i + 1 >= vals.size()) return vals.back();
+		return vals[i] + (pos - i) * (vals[i + 1] - vals[i]);
+	}
+
+	void estimates(const double *sums, double shift, std::vector<double> &S1, std::vector<double> &ST, double &mean, double &var)
+	{
+		// Sobol indices from the running sums of one replicate
+		// each base sample contributes f(A) and f(B) to the estimates of the mean and variance
+		// S1_i = E[ f(B) ( f(A_B^i) - f(A) ) ] / V, Saltelli 2010
+		// ST_i = E[ ( f(A) - f(A_B^i) )^2 ] / 2 V, Jansen 1999
+
+		const int P = sensitivity::N_PARAMS;
+		double W = sums[0];
+
+		double m = W > 0.0 ? sums[1] / (2.0 * W) : 0.0;
+		var = W > 0.0 ? sums[2] / (2.0 * W) - m * m : 0.0;
+		mean = m + shift;
+
+		for (int i = 0; i < P; i++) {
+			S1[i] = var > 0.0 ? (sums[3 + i] / W) / var : 0.0;
+			ST[i] = var > 0.0 ? 0.5 * (sums[3 + P + i] / W) / var : 0.0;
+		}
+	}
+
+	void sa_worker(std::vector<double> &lo, std::vector<double> &hi, sensitivity::sa_settings &opts, double shift, std::atomic<int> &next_block, std::vector<double> &acc)
+	{
+		// Evaluate blocks of base samples until none remain, adding their contributions to acc
+		// For a block of m base samples the population holds m rows each of A, B and A_B^i for i = 0 .. N_PARAMS-1
+		// acc holds N_SUMS running sums for the full sample followed by N_SUMS for each bootstrap replicate
+		// The bootstrap weight of a sample depends only on its index, so the result is the same, up to round-off, for any number of threads
+
+		const int P = sensitivity::N_PARAMS;
+		const int D = 2 * P;
+
+		int n_blocks = (opts.n_samples + opts.block - 1) / opts.block;
+
+		device_population pop(opts.block * (P + 2));
+		sobol_sequence seq(D);
+
+		std::vector<double> u(static_cast<size_t>(opts.block) * D);
+		std::vector<double> out;
+		double t[N_SUMS];
+
+		for (int b = next_block++; b < n_blocks; b = next_block++) {
+			int j0 = b * opts.block;
+			int m = std::min(opts.block, opts.n_samples - j0);
+
+			// point 0 of the Sobol sequence is the origin, it is skipped
+			seq.point(static_cast<unsigned int>(j0 + 1), &u[0]);
+			for (int k = 1; k < m; k++) seq.next(&u[k * D]);
+
+			pop.resize(m * (P + 2));
+
+			for (int p = 0; p < P; p++) {
+				double *col = pop.column(static_cast<pop_column>(p));
+				double range = hi[p] - lo[p];
+
+				for (int k = 0; k < m; k++) {
+					double a = lo[p] + range * u[k * D + p];
+					double bb = lo[p] + range * u[k * D + P + p];
+
+					col[k] = a;
+					col[m + k] = bb;
+					for (int i = 0; i < P; i++) col[(2 + i) * m + k] = (i == p) ? bb : a;
+				}
+			}
+			pop.invalidate();
+
+			pop.Pout(opts.wavelength, opts.current, out);
+
+			for (int k = 0; k < m; k++) {
+				double fA = out[k] - shift;
+				double fB = out[m + k] - shift;
+
+				t[0] = 1.0;
+				t[1] = fA + fB;
+				t[2] = fA * fA + fB * fB;
+				for (int i = 0; i < P; i++) {
+					double fAB = out[(2 + i) * m + k] - shift;
+					t[3 + i] = fB * (fAB - fA);
+					t[3 + P + i] = (fA - fAB) * (fA - fAB);
+				}
+
+				for (int q = 0; q < N_SUMS; q++) acc[q] += t[q];
+
+				unsigned long long h = splitmix64(static_cast<unsigned long long>(opts.seed) ^ (static_cast<unsigned long long>(j0 + k) << 20));
+				for (int r = 1; r <= opts.n_boot; r++) {
+					int w = poisson1(splitmix64(h + r));
+					if (w > 0) {
+						double *a = &acc[r * N_SUMS];
+						for (int q = 0; q < N_SUMS; q++) a[q] += w * t[q];
+					}
+				}
+			}
+		}
+	}
+}
+
+void sensitivity::ranges_from_nominal(std::vector<double> &nominal, double spread, std::vector<double> &lo, std::vector<double> &hi)
+{
+	// each parameter is varied by +/- spread about its nominal value, e.g. spread = 0.1 for +/- 10%
+	// nominal is ordered as in pop_column
+
+	lo.resize(nominal.size());
+	hi.resize(nominal.size());
+
+	for (size_t i = 0; i < nominal.size(); i++) {
+		lo[i] = nominal[i] * (1.0 - spread);
+		hi[i] = nominal[i] * (1.0 + spread);
+	}
+}
+
+bool sensitivity::sobol_indices(std::vector<double> &lo, std::vector<double> &hi, sa_settings &opts, sa_result &res)
+{
+	// Estimate first-order and total Sobol indices of Pout(wavelength, current) with respect to each laser parameter
+	// parameter p is uniformly distributed on [lo[p], hi[p]], lo and hi are ordered as in pop_column
+	// Model evaluations are made in blocks on separate threads and reduced to running sums as they are produced,
+	// so the memory used does not depend on n_samples
+	// Confidence intervals are computed with the Poisson bootstrap, in which each sample enters each replicate
+	// with a Poisson(1) weight, this can be done in the same pass as the main estimate
+
+	try {
+		const int P = N_PARAMS;
+
+		bool c1 = static_cast<int>(lo.size()) == P && static_cast<int>(hi.size()) == P;
+		bool c2 = c1;
+		for (int p = 0; p < P && c1; p++) if (!(lo[p] > 0.0 && hi[p] >= lo[p])) c2 = false;
+		if (c1 && (hi[COL_ETA] >= 1.1 || hi[COL_ETAI] >= 1.1)) c2 = false;
+		bool c3 = opts.n_samples > 0 && opts.n_boot >= 0 && opts.block > 0 && opts.conf > 0.0 && opts.conf < 1.0;
+
+		if (c1 && c2 && c3) {
+			// values are shifted by Pout at the centre of the parameter ranges to limit round-off in the running sums
+			device_population centre(1);
+			for (int p = 0; p < P; p++) centre.set(static_cast<pop_column>(p), 0, 0.5 * (lo[p] + hi[p]));
+			std::vector<double> fc;
+			centre.Pout(opts.wavelength, opts.current, fc);
+			double shift = fc[0];
+
+			int n_blocks = (opts.n_samples + opts.block - 1) / opts.block;
+			int n_max = opts.n_threads > 0 ? opts.n_threads : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+			int n_use = std::max(1, std::min(n_max, n_blocks));
+
+			std::atomic<int> next_block(0);
+			std::vector< std::vector<double> > acc(n_use, std::vector<double>(static_cast<size_t>(opts.n_boot + 1) * N_SUMS, 0.0));
+
+			// blocks are handed out through next_block, so if a thread cannot be started the threads already running,
+			// including the calling thread, share the remaining blocks between them and every started thread is still joined
+			// reserving first means push_back cannot throw once a thread has been created
+			std::vector<std::thread> workers;
+			workers.reserve(n_use);
+			for (int t = 1; t < n_use; t++) {
+				try {
+					workers.push_back( std::thread(sa_worker, std::ref(lo), std::ref(hi), std::ref(opts), shift, std::ref(next_block), std::ref(acc[t])) );
+				}
+				catch (std::system_error &) {
+					break;
+				}
+			}
+			sa_worker(lo, hi, opts, shift, next_block, acc[0]);
+			for (size_t t = 0; t < workers.size(); t++) workers[t].join();
+
+			for (int t = 1; t < n_use; t++) {
+				for (size_t q = 0; q < acc[0].size(); q++) acc[0][q] += acc[t][q];
+			}
+
+			res.S1.assign(P, 0.0); res.ST.assign(P, 0.0);
+			estimates(&acc[0][0], shift, res.S1, res.ST, res.mean, res.variance);
+			res.n_evals = static_cast<long long>(opts.n_samples) * (P + 2);
+
+			res.S1_lo = res.S1_hi = res.S1;
+			res.ST_lo = res.ST_hi = res.ST;
+
+			if (opts.n_boot > 0) {
+				std::vector< std::vector<double> > bS1(P, std::vector<double>(opts.n_boot)), bST(P, std::vector<double>(opts.n_boot));
+				std::vector<double> S1(P), ST(P);
+				double m, v;
+
+				for (int r = 1; r <= opts.n_boot; r++) {
+					estimates(&acc[0][r * N_SUMS], shift, S1, ST, m, v);
+					for (int i = 0; i < P; i++) { bS1[i][r - 1] = S1[i]; bST[i][r - 1] = ST[i]; }
+				}
+
+				double qlo = 0.5 * (1.0 - opts.conf), qhi = 0.5 * (1.0 + opts.conf);
+				for (int i = 0; i < P; i++) {
+					res.S1_lo[i] = quantile(bS1[i], qlo); res.S1_hi[i] = quantile(bS1[i], qhi);
+					res.ST_lo[i] = quantile(bST[i], qlo); res.ST_hi[i] = quantile(bST[i], qhi);
+				}
+			}
+
+			return true;
+		}
+		else {
+			std::string reason = "Error: sensitivity::sobol_indices(std::vector<double> &lo, std::vector<double> &hi, sa_settings &opts, sa_result &res)\n";
+			if (!c1) reason += "lo and hi must each hold " + template_funcs::toString(P) + " values\n";
+			if (c1 && !c2) reason += "Parameter ranges are not correctly defined\n";
+			if (!c3) reason += "Analysis settings are not correctly defined\n";
+			throw std::runtime_error(reason);
+		}
+	}
+	catch (std::runtime_error &e) {
+		std::cerr << e.what();
+		return false;
+	}
+}
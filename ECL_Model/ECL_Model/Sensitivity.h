@@ -0,0 +1,71 @@
+#ifndef SENSITIVITY_H
+#define SENSITIVITY_H
+
+// Global sensitivity analysis of the ECL model output power with respect to the laser parameters
+// First-order and total Sobol indices are estimated using the Saltelli sampling scheme
+// A. Saltelli et al, Variance based sensitivity analysis of model output, Comp. Phys. Comm., 181, 2010
+// Samples are drawn from a Sobol quasi-random sequence, direction numbers are those of
+// S. Joe and F. Y. Kuo, Constructing Sobol sequences with better two-dimensional projections, SIAM J. Sci. Comput., 30, 2008
+
+// Sobol quasi-random sequence in up to MAX_DIM dimensions
+
+class sobol_sequence {
+public:
+	sobol_sequence();
+	sobol_sequence(int dimension);
+
+	void set_params(int dimension);
+
+	void point(unsigned int index, double *x);
+
+	void next(double *x);
+
+	inline int get_dim() { return dim; }
+	inline unsigned int get_index() { return idx; }
+
+	static const int MAX_DIM = 21;
+
+private:
+	static const int BITS = 32;
+
+	int dim; // number of dimensions
+	unsigned int idx; // index of the next point to be generated by next()
+
+	std::vector<unsigned int> v; // direction numbers, v[d * BITS + k]
+	std::vector<unsigned int> state; // integer coordinates of the last point generated
+};
+
+namespace sensitivity {
+
+	static const int N_PARAMS = COL_ITH + 1; // eta, etai, L, Lgout, Rg, Rr, alpha, alphag, ZT, Ith, ordered as in pop_column
+
+	// Parameters for the analysis
+	struct sa_settings {
+		sa_settings() : wavelength(1550.0), current(0.1), n_samples(1 << 16), n_boot(100), conf(0.95), n_threads(0), block(1024), seed(1) {}
+
+		double wavelength; // lasing wavelength in nm
+		double current; // operating current at which Pout is evaluated
+		int n_samples; // number of base samples N, the model is evaluated N ( N_PARAMS + 2 ) times
+		int n_boot; // number of bootstrap replicates used for the confidence intervals
+		double conf; // confidence level of the intervals, e.g. 0.95
+		int n_threads; // number of threads, 0 uses all available hardware threads
+		int block; // number of base samples evaluated together as one device_population
+		unsigned int seed; // seed for the bootstrap resampling weights
+	};
+
+	// Sobol indices for each parameter, indexed as in pop_column
+	struct sa_result {
+		std::vector<double> S1, ST; // first-order and total indices
+		std::vector<double> S1_lo, S1_hi; // confidence interval for S1
+		std::vector<double> ST_lo, ST_hi; // confidence interval for ST
+		double mean; // mean of Pout
+		double variance; // variance of Pout
+		long long n_evals; // number of model evaluations
+	};
+
+	void ranges_from_nominal(std::vector<double> &nominal, double spread, std::vector<double> &lo, std::vector<double> &hi);
+
+	bool sobol_indices(std::vector<double> &lo, std::vector<double> &hi, sa_settings &opts, sa_result &res);
+}
+
+#endif
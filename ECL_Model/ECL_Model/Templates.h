@@ -63,7 +63,7 @@ namespace template_funcs{
 	template <typename T> void sort2(std::vector<T> &vec1, std::vector<T> &vec2)
 	{
 		// Sort vec1 into ascending order using while making the corresponding rearrangement of vec2
-		// This is an implementation of the NRinC::sort2 using std::sort
+		// This is an implementation of the NRinC::sort2
 		// vec1 and vec2 must have the same number of elements
 		// R. Sheehan 10 - 1 - 2018
 
@@ -71,6 +71,10 @@ namespace template_funcs{
 		// it must be declared as type void to ensure it compiles correctly
 		// see https://stackoverflow.com/questions/1640758/passing-stdvector-for-any-type-to-a-function
 
+		// The sorting permutation is computed from vec1 and applied to both vectors in place by data_prep::co_sort
+		// rather than copying the data into a temporary std::vector< std::pair<T,T> >
+		// elements of vec1 that are equal keep their original order
+
 		try{
 			bool c1 = vec1.size() == vec2.size() ? true : false; // vec1 and vec2 must have the same dimensions!
 			bool c2 = vec1.size() > 0 ? true : false; 
@@ -78,45 +82,18 @@ namespace template_funcs{
 			bool c4 = (c1 && c2 && c3) ? true : false;
 
 			if(c4){
-				// Join the data sets together to form a single container
-				// use the pair data type rather than std::vector<std::vector<double>> Data; 
-				std::vector< std::pair< T, T > > Data; 
-
-				// Store the data from vec1 and vec2 in Data
-				// vec1 and vec2 must have the same dimensions!
-				// vec1 corresponds to the first column, vec2 to the second				
-				//std::vector<T>::iterator it1 = vec1.begin(); 
-				//std::vector<T>::iterator it2 = vec2.begin();
-				std::iterator it1 = vec1.begin(); 
-				std::iterator it2 = vec2.begin();
-				for(it1; it1 != vec1.end(); it1++){
-					Data.push_back( std::make_pair(*it1, *it2) ); 
-					it2++; 
-				}
-
-				// sort the data using std::sort
-				// this will sort according to the data in the first element of the pair
-				// the same rearrangement will be applied to the data in the second element
-				std::sort(Data.begin(), Data.end()); 
-
-				// place the sorted data back into the original containers		
-				//std::vector< std::pair<T,T> >::iterator pit = Data.begin(); 
-				std::iterator pit = Data.begin();
-				int i=0; 
-				for(pit; pit != Data.end(); pit++){
-					vec1[i] = pit->first; vec2[i] = pit->second; 
-					i++; 
-				}
-
-				// no longer need Data
-				Data.clear(); 
+				std::vector< std::vector<T>* > cols; 
+				cols.push_back(&vec1); 
+				cols.push_back(&vec2); 
+
+				data_prep::co_sort(cols, 0); 
 			}
 			else{
 				std::string reason; 
 				reason = "Error: template_funcs::Sort2\n"; 
 				if(!c1) reason+="vec1 and vec2 have different sizes\n"; 
 				if(!c2) reason+="vec1 has no elements\n";
-				if(!c3) reason+="vec1 has no elements\n";
+				if(!c3) reason+="vec2 has no elements\n";
 				throw std::invalid_argument(reason); 
 			}
 		}
@@ -0,0 +1,580 @@
+#ifndef ATTACH_H
+#include "Attach.h"
+#endif
+
+#include "ECL_C_API.h"
+
+// Definitions of the functions in the testing namespace
+
+bool testing::device_population_ec_laser(int n_devices, bool loud)
+{
+	// Build a population of n_devices lasers with different parameters and compare it with one ec_laser per device
+	// Passes if Pout agrees with ec_laser::Pout for every device and current, invalid devices give zero power,
+	// every column starts on a 64 byte boundary and a copy of the population gives the same results as the original
+
+	const double wl = 1550.0;
+	const int n_curr = 5;
+	double currents[n_curr] = {-0.01, 0.0, 0.015, 0.05, 0.1};
+
+	device_population pop;
+	std::vector<ec_laser> lasers;
+
+	for (int i = 0; i < n_devices; i++) {
+		double eta = 0.5 + 0.4 * (i % 7) / 6.0, etai = 0.6 + 0.3 * (i % 11) / 10.0;
+		lengths theLength(0.05 + 0.01 * (i % 5), 0.01 + 0.01 * (i % 3));
+		reflections theRefs(0.1 + 0.05 * (i % 9), 0.8 + 0.01 * (i % 13));
+		losses theLoss(2.0 + (i % 4), 1.0 + 0.5 * (i % 6));
+		dcvals theDC(10.0, 0.01 + 0.001 * (i % 17));
+
+		pop.add_device(eta, etai, theLength, theRefs, theLoss, theDC);
+		lasers.push_back(ec_laser(eta, etai, theLength, theRefs, theLoss, theDC));
+	}
+
+	int n_bad = 0;
+	std::vector<double> out;
+
+	for (int c = 0; c < n_curr; c++) {
+		pop.Pout(wl, currents[c], out);
+		for (int i = 0; i < n_devices; i++) {
+			if (fabs(out[i] - lasers[i].Pout(wl, currents[c])) > 1.0e-12) n_bad++;
+		}
+	}
+
+	// device i driven at its own current
+	std::vector<double> cur(n_devices);
+	for (int i = 0; i < n_devices; i++) cur[i] = currents[i % n_curr];
+	pop.Pout(wl, cur, out);
+	for (int i = 0; i < n_devices; i++) {
+		if (fabs(out[i] - lasers[i].Pout(wl, cur[i])) > 1.0e-12) n_bad++;
+	}
+
+	// every column of the arena must be aligned
+	for (int col = 0; col < N_POP_COLS; col++) {
+		if (reinterpret_cast<size_t>(pop.read_column(static_cast<pop_column>(col))) % 64 != 0) n_bad++;
+	}
+
+	// a copy must have its own aligned arena and give the same results
+	device_population dup(pop);
+	std::vector<double> out_dup;
+	dup.Pout(wl, 0.1, out_dup);
+	pop.Pout(wl, 0.1, out);
+	if (dup.size() != pop.size() || out_dup != out) n_bad++;
+	for (int col = 0; col < N_POP_COLS; col++) {
+		if (dup.read_column(static_cast<pop_column>(col)) == pop.read_column(static_cast<pop_column>(col))) n_bad++;
+		if (reinterpret_cast<size_t>(dup.read_column(static_cast<pop_column>(col))) % 64 != 0) n_bad++;
+	}
+
+	// invalid devices must give no output power, the copy must not be affected
+	const int n_invalid = 3;
+	pop.set(COL_L, 0, -1.0);
+	pop.set(COL_RG, n_devices / 2, 0.0);
+	pop.set(COL_ETA, n_devices - 1, 1.5);
+
+	if (pop.validate() != n_invalid) n_bad++;
+
+	pop.Pout(wl, 0.1, out);
+	if (out[0] != 0.0 || out[n_devices / 2] != 0.0 || out[n_devices - 1] != 0.0) n_bad++;
+	for (int i = 1; i < n_devices - 1; i++) {
+		if (i != n_devices / 2 && fabs(out[i] - lasers[i].Pout(wl, 0.1)) > 1.0e-12) n_bad++;
+	}
+
+	dup.Pout(wl, 0.1, out);
+	if (out != out_dup) n_bad++;
+
+	bool passed = (n_bad == 0);
+
+	if (loud) {
+		std::cout << "testing::device_population_ec_laser: " << (passed ? "passed" : "failed") << "\n";
+		if (!passed) std::cout << n_bad << " checks failed\n";
+	}
+
+	return passed;
+}
+
+bool testing::device_population_column_write(bool loud)
+{
+	// Write a parameter through the pointer returned by column() after Pout has been computed
+	// Passes if Pout is unchanged until invalidate() is called and then agrees with an ec_laser built from the new parameters
+
+	double eta = 0.8, etai = 0.9, etai_new = 0.45;
+	lengths theLength(0.1, 0.05); reflections theRefs(0.3, 0.9); losses theLoss(5.0, 2.0); dcvals theDC(10.0, 0.02);
+
+	device_population pop;
+	pop.add_device(eta, etai, theLength, theRefs, theLoss, theDC);
+	pop.add_device(eta, etai, theLength, theRefs, theLoss, theDC);
+
+	std::vector<double> before, after;
+
+	double *col = pop.column(COL_ETAI);
+	pop.Pout(1550.0, 0.1, before);
+
+	col[0] = etai_new;
+	pop.invalidate();
+	pop.Pout(1550.0, 0.1, after);
+
+	ec_laser changed(eta, etai_new, theLength, theRefs, theLoss, theDC);
+	ec_laser unchanged(eta, etai, theLength, theRefs, theLoss, theDC);
+
+	bool passed = pop.derived_ready();
+	passed = passed && fabs(after[0] - changed.Pout(1550.0, 0.1)) < 1.0e-12;
+	passed = passed && fabs(after[1] - unchanged.Pout(1550.0, 0.1)) < 1.0e-12;
+	passed = passed && fabs(after[0] - before[0]) > 1.0e-6;
+
+	if (loud) std::cout << "testing::device_population_column_write: " << (passed ? "passed" : "failed") << "\n";
+
+	return passed;
+}
+
+bool testing::pipeline_exactly_once(int n_items, bool loud)
+{
+	// Push n_items tagged items through a three stage pipeline with several threads per stage
+	// Queues hold only two items so that the full and empty waits, and the close protocol, are exercised constantly
+	// Passes if every item arrives at the sink exactly once and the pipeline shuts down
+
+	const int depth = 2, n_threads = 3;
+
+	std::unique_ptr< std::atomic<int>[] > seen(new std::atomic<int>[n_items]);
+	for (int i = 0; i < n_items; i++) seen[i].store(0);
+
+	pipeline::bounded_queue<int> q_in(depth);
+	pipeline::bounded_queue<long long> q_mid(depth);
+	pipeline::bounded_queue<long long> q_out(depth);
+
+	// stage 1 attaches a check value to the tag, stage 2 verifies and removes it
+	pipeline::stage<int, long long> first(q_in, q_mid, n_threads,
+		[](int &in, long long &out) { out = (static_cast<long long>(in) << 20) | (in % 1000); return true; });
+
+	pipeline::stage<long long, long long> second(q_mid, q_out, n_threads,
+		[](long long &in, long long &out) { long long tag = in >> 20; out = ((in & 0xFFFFF) == tag % 1000) ? tag : -1; return true; });
+
+	std::atomic<int> n_bad(0);
+	pipeline::sink_stage<long long> last(q_out, n_threads,
+		[&seen, &n_bad, n_items](long long &in) { if (in >= 0 && in < n_items) seen[in]++; else n_bad++; });
+
+	first.start(); second.start(); last.start();
+
+	q_in.add_producers(1);
+	for (int i = 0; i < n_items; i++) {
+		int tag = i;
+		q_in.push(tag);
+	}
+	q_in.producer_done();
+
+	first.join(); second.join(); last.join();
+
+	int n_missing = 0, n_repeat = 0;
+	for (int i = 0; i < n_items; i++) {
+		if (seen[i].load() == 0) n_missing++;
+		if (seen[i].load() > 1) n_repeat++;
+	}
+
+	bool passed = (n_missing == 0 && n_repeat == 0 && n_bad.load() == 0);
+
+	if (loud) {
+		std::cout << "testing::pipeline_exactly_once: " << (passed ? "passed" : "failed") << "\n";
+		if (!passed) std::cout << n_missing << " missing, " << n_repeat << " repeated, " << n_bad.load() << " corrupted\n";
+	}
+
+	return passed;
+}
+
+bool testing::li_workflow_missing_file(bool loud)
+{
+	// Run li_workflow::run on a list of LI files in which one file does not exist
+	// Passes if run returns, the missing file is reported as failed and every other file is fitted correctly
+
+	double eta = 0.8, etai = 0.9;
+	lengths theLength(0.1, 0.05); reflections theRefs(0.3, 0.9); losses theLoss(5.0, 2.0); dcvals theDC(10.0, 0.02);
+	ec_laser nominal(eta, etai, theLength, theRefs, theLoss, theDC);
+
+	const int n_files = 20, missing = 7;
+	std::vector<std::string> filenames;
+
+	for (int k = 0; k < n_files; k++) {
+		std::string name = "Test_LI_" + template_funcs::toString(k) + ".txt";
+		filenames.push_back(name);
+
+		if (k == missing) {
+			std::remove(name.c_str());
+		}
+		else {
+			std::ofstream write(name, std::ios_base::out | std::ios_base::trunc);
+			for (int i = 0; i < 100; i++) {
+				double I = 0.001 * i;
+				write << std::setprecision(12) << I << " " << std::max(0.0, nominal.Pout(1550.0, I)) << "\n";
+			}
+			write.close();
+		}
+	}
+
+	li_workflow::li_settings opts;
+	std::vector<li_workflow::li_fit> results;
+
+	li_workflow::run(filenames, nominal, opts, results);
+
+	bool passed = static_cast<int>(results.size()) == n_files;
+	for (int k = 0; k < n_files && passed; k++) {
+		if (k == missing) passed = !results[k].ok;
+		else passed = results[k].ok && fabs(results[k].Ith - 0.02) < 1.0e-6;
+	}
+
+	// tidy up
+	for (int k = 0; k < n_files; k++) {
+		std::remove(filenames[k].c_str());
+		std::remove(li_workflow::output_name(filenames[k]).c_str());
+	}
+
+	if (loud) std::cout << "testing::li_workflow_missing_file: " << (passed ? "passed" : "failed") << "\n";
+
+	return passed;
+}
+
+bool testing::c_api_strides(bool loud)
+{
+	// Call the C interface with contiguous, strided, reversed and repeated arrays and with invalid arguments
+	// Passes if every status code is as documented in ECL_C_API.h and the results agree with ec_laser::Pout and li_workflow::fit_li
+
+	const double wl = 1550.0;
+	const ptrdiff_t sz = static_cast<ptrdiff_t>(sizeof(double));
+
+	double eta = 0.8, etai = 0.9;
+	lengths theLength(0.1, 0.05); reflections theRefs(0.3, 0.9); losses theLoss(5.0, 2.0); dcvals theDC(10.0, 0.02);
+	ec_laser ref(eta, etai, theLength, theRefs, theLoss, theDC);
+
+	int n_bad = 0;
+
+	// handle creation
+	ecl_laser *las = nullptr, *bad = nullptr;
+	if (ecl_create(eta, etai, 0.1, 0.05, 0.3, 0.9, 5.0, 2.0, 10.0, 0.02, &las) != ECL_OK || las == nullptr) n_bad++;
+	if (ecl_create(eta, etai, -0.1, 0.05, 0.3, 0.9, 5.0, 2.0, 10.0, 0.02, &bad) != ECL_ERR_PARAM || bad != nullptr) n_bad++;
+	if (ecl_create(1.5, etai, 0.1, 0.05, 0.3, 0.9, 5.0, 2.0, 10.0, 0.02, &bad) != ECL_ERR_PARAM || bad != nullptr) n_bad++;
+	if (ecl_create(eta, etai, 0.1, 0.05, 0.3, 0.9, 5.0, 2.0, 10.0, 0.02, nullptr) != ECL_ERR_NULL) n_bad++;
+
+	if (las != nullptr) {
+		const int n = 200;
+		std::vector<double> current(n), pout(n), expect(n);
+		for (int i = 0; i < n; i++) {
+			current[i] = 0.0005 * i;
+			expect[i] = ref.Pout(wl, current[i]);
+		}
+
+		// contiguous, on one thread and on several
+		for (int nt = 1; nt <= 4; nt += 3) {
+			std::fill(pout.begin(), pout.end(), -1.0);
+			if (ecl_pout(las, wl, current.data(), sz, pout.data(), sz, n, nt) != ECL_OK) n_bad++;
+			for (int i = 0; i < n; i++) if (fabs(pout[i] - expect[i]) > 1.0e-12) n_bad++;
+		}
+
+		// negative strides, both arrays are walked from their last element
+		std::fill(pout.begin(), pout.end(), -1.0);
+		if (ecl_pout(las, wl, current.data() + n - 1, -sz, pout.data() + n - 1, -sz, n, 2) != ECL_OK) n_bad++;
+		for (int i = 0; i < n; i++) if (fabs(pout[i] - expect[i]) > 1.0e-12) n_bad++;
+
+		// every second current written to the interleaved output, the other elements must not be touched
+		std::fill(pout.begin(), pout.end(), -1.0);
+		if (ecl_pout(las, wl, current.data(), 2 * sz, pout.data() + 1, 2 * sz, n / 2, 1) != ECL_OK) n_bad++;
+		for (int i = 0; i < n; i += 2) if (pout[i] != -1.0 || fabs(pout[i + 1] - expect[i]) > 1.0e-12) n_bad++;
+
+		// zero input stride repeats the same current
+		if (ecl_pout(las, wl, current.data() + 100, 0, pout.data(), sz, n, 1) != ECL_OK) n_bad++;
+		for (int i = 0; i < n; i++) if (fabs(pout[i] - expect[100]) > 1.0e-12) n_bad++;
+
+		// thermal model
+		double T = 30.0, gamma = 0.1, T0 = 50.0, T1 = 200.0;
+		if (ecl_pout_thermal(las, wl, T, gamma, T0, T1, current.data(), sz, pout.data(), sz, n, 1) != ECL_OK) n_bad++;
+		for (int i = 0; i < n; i++) if (fabs(pout[i] - ref.Pout(wl, current[i], T, gamma, 0.0, T0, T1)) > 1.0e-12) n_bad++;
+
+		// invalid strides and arguments
+		if (ecl_pout(las, wl, current.data(), 12, pout.data(), sz, n, 1) != ECL_ERR_STRIDE) n_bad++;
+		if (ecl_pout(las, wl, current.data(), sz, pout.data(), -4, n, 1) != ECL_ERR_STRIDE) n_bad++;
+		if (ecl_pout(las, wl, current.data(), sz, pout.data(), 0, n, 1) != ECL_ERR_STRIDE) n_bad++;
+		if (ecl_pout(las, wl, current.data(), sz, pout.data(), 0, 1, 1) != ECL_ERR_STRIDE) n_bad++;
+		if (ecl_pout_thermal(las, wl, T, gamma, T0, T1, current.data(), sz, pout.data(), 0, n, 1) != ECL_ERR_STRIDE) n_bad++;
+		if (ecl_pout(las, wl, nullptr, sz, pout.data(), sz, n, 1) != ECL_ERR_NULL) n_bad++;
+		if (ecl_pout(nullptr, wl, current.data(), sz, pout.data(), sz, n, 1) != ECL_ERR_NULL) n_bad++;
+
+		ecl_destroy(las);
+	}
+
+	// Fit a set of curves with different thresholds, current is shared by every curve through a zero row stride
+	// power is stored both row-major and column-major, the last curve has no output power and cannot be fitted
+	const int n_curves = 6, n_pts = 100;
+	std::vector<double> current(n_pts), power(n_curves * n_pts), power_t(n_curves * n_pts);
+	std::vector<li_workflow::li_fit> expect(n_curves);
+
+	for (int j = 0; j < n_pts; j++) current[j] = 0.001 * j;
+
+	for (int c = 0; c < n_curves; c++) {
+		dcvals dc(10.0, 0.01 + 0.005 * c);
+		ec_laser las_c(eta, etai, theLength, theRefs, theLoss, dc);
+
+		std::vector<double> p(n_pts);
+		for (int j = 0; j < n_pts; j++) {
+			p[j] = (c < n_curves - 1) ? std::max(0.0, las_c.Pout(wl, current[j])) : 0.0;
+			power[c * n_pts + j] = power_t[j * n_curves + c] = p[j];
+		}
+
+		if (c < n_curves - 1) li_workflow::fit_li(current, p, wl, 0.2, expect[c]);
+	}
+
+	for (int layout = 0; layout < 2; layout++) {
+		std::vector<ecl_fit_result> res(n_curves);
+		ecl_status st;
+
+		if (layout == 0) st = ecl_fit_li(current.data(), 0, sz, power.data(), n_pts * sz, sz, n_curves, n_pts, wl, 0.2, res.data(), 1);
+		else st = ecl_fit_li(current.data(), 0, sz, power_t.data(), sz, n_curves * sz, n_curves, n_pts, wl, 0.2, res.data(), 4);
+
+		if (st != ECL_ERR_FIT || res[n_curves - 1].ok != 0) n_bad++;
+
+		for (int c = 0; c < n_curves - 1; c++) {
+			bool c1 = res[c].ok == 1 && res[c].n_fit == expect[c].n_fit;
+			bool c2 = fabs(res[c].slope - expect[c].slope) < 1.0e-12 && fabs(res[c].Ith - expect[c].Ith) < 1.0e-12;
+			bool c3 = fabs(res[c].RQfactor - expect[c].RQfactor) < 1.0e-12 && fabs(res[c].Ith - (0.01 + 0.005 * c)) < 1.0e-9;
+			if (!(c1 && c2 && c3)) n_bad++;
+		}
+	}
+
+	std::vector<ecl_fit_result> res(n_curves);
+	if (ecl_fit_li(current.data(), 0, 4, power.data(), n_pts * sz, sz, n_curves, n_pts, wl, 0.2, res.data(), 1) != ECL_ERR_STRIDE) n_bad++;
+	if (ecl_fit_li(current.data(), 0, sz, power.data(), n_pts * sz, sz, n_curves, n_pts, wl, 0.2, nullptr, 1) != ECL_ERR_NULL) n_bad++;
+
+	bool passed = (n_bad == 0);
+
+	if (loud) {
+		std::cout << "testing::c_api_strides: " << (passed ? "passed" : "failed") << "\n";
+		if (!passed) std::cout << n_bad << " checks failed\n";
+	}
+
+	return passed;
+}
+
+bool testing::data_prep_co_sort(int n_rows, int n_threads, bool loud)
+{
+	// Co-sort four columns by a key column with many repeated values
+	// With the default arguments the key is split into five runs, so the parallel merge carries an odd run out in two rounds
+	// Passes if the key is ascending, rows stay together, rows with equal keys keep their input order
+	// and template_funcs::sort2 behaves in the same way on a small example
+
+	std::vector<double> key(n_rows), row(n_rows), twice(n_rows), neg(n_rows);
+	for (int i = 0; i < n_rows; i++) {
+		key[i] = static_cast<double>((static_cast<long long>(i) * 7919) % 1000);
+		row[i] = i;
+		twice[i] = 2.0 * key[i];
+		neg[i] = -i;
+	}
+
+	std::vector< std::vector<double>* > cols;
+	cols.push_back(&row); cols.push_back(&key); cols.push_back(&twice); cols.push_back(&neg);
+
+	data_prep::co_sort(cols, 1, n_threads);
+
+	int n_bad = 0;
+	for (int i = 0; i < n_rows; i++) {
+		long long j = static_cast<long long>(row[i]);
+		if (key[i] != static_cast<double>((j * 7919) % 1000) || twice[i] != 2.0 * key[i] || neg[i] != -row[i]) n_bad++;
+		if (i > 0 && (key[i] < key[i - 1] || (key[i] == key[i - 1] && row[i] < row[i - 1]))) n_bad++;
+	}
+
+	// the serial path must give the same order
+	std::vector<double> key_1(n_rows), row_1(n_rows);
+	for (int i = 0; i < n_rows; i++) {
+		key_1[i] = static_cast<double>((static_cast<long long>(i) * 7919) % 1000);
+		row_1[i] = i;
+	}
+	std::vector< std::vector<double>* > cols_1;
+	cols_1.push_back(&key_1); cols_1.push_back(&row_1);
+	data_prep::co_sort(cols_1, 0, 1);
+	if (row_1 != row) n_bad++;
+
+	// sort2 keeps equal keys in their input order rather than ordering them by vec2
+	double v1[5] = {3.0, 1.0, 2.0, 1.0, 3.0}, v2[5] = {5.0, 4.0, 3.0, 2.0, 1.0};
+	double s1[5] = {1.0, 1.0, 2.0, 3.0, 3.0}, s2[5] = {4.0, 2.0, 3.0, 5.0, 1.0};
+	std::vector<double> vec1(v1, v1 + 5), vec2(v2, v2 + 5);
+	template_funcs::sort2(vec1, vec2);
+	if (vec1 != std::vector<double>(s1, s1 + 5) || vec2 != std::vector<double>(s2, s2 + 5)) n_bad++;
+
+	bool passed = (n_bad == 0);
+
+	if (loud) {
+		std::cout << "testing::data_prep_co_sort: " << (passed ? "passed" : "failed") << "\n";
+		if (!passed) std::cout << n_bad << " checks failed\n";
+	}
+
+	return passed;
+}
+
+bool testing::data_prep_dedupe_resample(bool loud)
+{
+	// Check data_prep::dedupe with averaging and with keep-first, with and without a key tolerance
+	// and data_prep::resample inside the data and beyond both ends, where values are clamped to the end points
+
+	int n_bad = 0;
+
+	// exact duplicates
+	double k0[6] = {1.0, 1.0, 1.0, 2.0, 3.0, 3.0}, y0[6] = {1.0, 2.0, 3.0, 4.0, 5.0, 7.0};
+
+	for (int avg = 0; avg < 2; avg++) {
+		std::vector<double> k(k0, k0 + 6), y(y0, y0 + 6);
+		std::vector< std::vector<double>* > cols;
+		cols.push_back(&k); cols.push_back(&y);
+
+		int n = data_prep::dedupe(cols, 0, avg == 1);
+
+		double ke[3] = {1.0, 2.0, 3.0}, ya[3] = {2.0, 4.0, 6.0}, yf[3] = {1.0, 4.0, 5.0};
+		if (n != 3 || k != std::vector<double>(ke, ke + 3)) n_bad++;
+		if (y != (avg == 1 ? std::vector<double>(ya, ya + 3) : std::vector<double>(yf, yf + 3))) n_bad++;
+	}
+
+	// keys within tol of the first key of a run are merged, the key column keeps the first key
+	{
+		double k1[4] = {1.0, 1.05, 1.2, 1.25}, y1[4] = {2.0, 4.0, 6.0, 10.0};
+		std::vector<double> k(k1, k1 + 4), y(y1, y1 + 4);
+		std::vector< std::vector<double>* > cols;
+		cols.push_back(&y); cols.push_back(&k);
+
+		int n = data_prep::dedupe(cols, 1, true, 0.1);
+
+		if (n != 2 || k[0] != 1.0 || k[1] != 1.2 || fabs(y[0] - 3.0) > 1.0e-12 || fabs(y[1] - 8.0) > 1.0e-12) n_bad++;
+	}
+
+	// resample two columns, grid runs past both ends of x
+	{
+		double x0[3] = {0.0, 1.0, 2.0}, ya0[3] = {0.0, 10.0, 40.0}, yb0[3] = {1.0, -1.0, 1.0};
+		std::vector<double> x(x0, x0 + 3), ya(ya0, ya0 + 3), yb(yb0, yb0 + 3);
+		std::vector< std::vector<double>* > ys;
+		ys.push_back(&ya); ys.push_back(&yb);
+
+		std::vector<double> grid;
+		data_prep::uniform_grid(-1.0, 3.0, 9, grid);
+
+		std::vector< std::vector<double> > out;
+		data_prep::resample(x, ys, grid, out);
+
+		double ea[9] = {0.0, 0.0, 0.0, 5.0, 10.0, 25.0, 40.0, 40.0, 40.0};
+		double eb[9] = {1.0, 1.0, 1.0, 0.0, -1.0, 0.0, 1.0, 1.0, 1.0};
+
+		if (grid.size() != 9 || grid[0] != -1.0 || grid[8] != 3.0 || out.size() != 2) n_bad++;
+		for (int k = 0; k < 9 && out.size() == 2 && out[0].size() == 9 && out[1].size() == 9; k++) {
+			if (fabs(out[0][k] - ea[k]) > 1.0e-12 || fabs(out[1][k] - eb[k]) > 1.0e-12) n_bad++;
+		}
+	}
+
+	bool passed = (n_bad == 0);
+
+	if (loud) {
+		std::cout << "testing::data_prep_dedupe_resample: " << (passed ? "passed" : "failed") << "\n";
+		if (!passed) std::cout << n_bad << " checks failed\n";
+	}
+
+	return passed;
+}
+
+bool testing::sobol_sequence_reference(bool loud)
+{
+	// Compare points of sobol_sequence with reference values for the Joe-Kuo new-joe-kuo-6.21201 direction numbers in Gray code order
+	// reference values were generated with scipy.stats.qmc.Sobol(21, scramble=False)
+	// points 0 - 7 only use the first three direction numbers of each dimension, points 1000 and 54321 use the higher ones
+	// every reference coordinate is a dyadic rational, so the comparison is exact
+
+	const int D = sobol_sequence::MAX_DIM;
+
+	// first eight points in units of 1/8
+	const int first[8][D] = {
+		{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+		{4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4},
+		{6, 2, 2, 2, 6, 6, 2, 6, 6, 6, 6, 6, 2, 2, 6, 2, 6, 2, 6, 2, 2},
+		{2, 6, 6, 6, 2, 2, 6, 2, 2, 2, 2, 2, 6, 6, 2, 6, 2, 6, 2, 6, 6},
+		{3, 3, 5, 7, 3, 1, 3, 7, 7, 5, 7, 3, 3, 5, 3, 7, 3, 7, 7, 1, 1},
+		{7, 7, 1, 3, 7, 5, 7, 3, 3, 1, 3, 7, 7, 1, 7, 3, 7, 3, 3, 5, 5},
+		{5, 1, 7, 5, 5, 7, 1, 1, 1, 3, 1, 5, 1, 7, 5, 5, 5, 5, 1, 3, 3},
+		{1, 5, 3, 1, 1, 3, 5, 5, 5, 7, 5, 1, 5, 3, 1, 1, 1, 1, 5, 7, 7}
+	};
+
+	// point 1000 in units of 1/1024
+	const int p1000[D] = {225, 99, 531, 693, 287, 929, 47, 921, 513, 71, 87, 261, 165, 393, 147, 379, 737, 353, 1015, 743, 535};
+
+	// point 54321 in units of 1/65536
+	const int p54321[D] = {38013, 38699, 48017, 12657, 26599, 37447, 44907, 29445, 62121, 32337, 5347, 16099, 40331, 58301, 43107, 55413, 8375, 52471, 53837, 56631, 33183};
+
+	sobol_sequence seq(D);
+	std::vector<double> x(D);
+	int n_bad = 0;
+
+	// next() from the start of the sequence
+	for (int k = 0; k < 8; k++) {
+		seq.next(x.data());
+		for (int d = 0; d < D; d++) if (x[d] != first[k][d] / 8.0) n_bad++;
+	}
+
+	// point() anywhere in the sequence
+	seq.point(1000, x.data());
+	for (int d = 0; d < D; d++) if (x[d] != p1000[d] / 1024.0) n_bad++;
+
+	seq.point(54321, x.data());
+	for (int d = 0; d < D; d++) if (x[d] != p54321[d] / 65536.0) n_bad++;
+
+	// next() continues from the point given to point()
+	seq.point(5, x.data());
+	seq.next(x.data());
+	for (int d = 0; d < D; d++) if (x[d] != first[6][d] / 8.0) n_bad++;
+
+	bool passed = (n_bad == 0);
+
+	if (loud) {
+		std::cout << "testing::sobol_sequence_reference: " << (passed ? "passed" : "failed") << "\n";
+		if (!passed) std::cout << n_bad << " coordinates differ from the reference values\n";
+	}
+
+	return passed;
+}
+
+bool testing::sobol_indices_analytic(bool loud)
+{
+	// Compare sensitivity::sobol_indices with the exact indices of a model for which they are known
+	// Only etai and Ith are varied, every other parameter is fixed, so Pout = c X Z with X = etai and Z = current - Ith
+	// For independent X and Z the variance of Pout splits into
+	// V_X = Var(X) E(Z)^2, V_Z = Var(Z) E(X)^2, V_XZ = Var(X) Var(Z), V = V_X + V_Z + V_XZ
+	// so that S1_X = V_X / V, ST_X = ( V_X + V_XZ ) / V and likewise for Z
+	// The fixed parameters must have S1 = ST = 0
+
+	const int P = sensitivity::N_PARAMS;
+	const double tol = 0.01;
+
+	double nominal[P] = {0.8, 0.5, 0.1, 0.05, 0.3, 0.9, 5.0, 2.0, 10.0, 0.05}; // ordered as in pop_column
+
+	std::vector<double> lo(nominal, nominal + P), hi(nominal, nominal + P);
+	lo[COL_ETAI] = 0.2; hi[COL_ETAI] = 1.0;
+	lo[COL_ITH] = 0.01; hi[COL_ITH] = 0.09;
+
+	sensitivity::sa_settings opts;
+	opts.current = 0.1;
+	opts.n_samples = 1 << 14;
+
+	// moments of uniform X = etai and Z = current - Ith
+	double EX = 0.5 * (lo[COL_ETAI] + hi[COL_ETAI]), VX = template_funcs::DSQR(hi[COL_ETAI] - lo[COL_ETAI]) / 12.0;
+	double EZ = opts.current - 0.5 * (lo[COL_ITH] + hi[COL_ITH]), VZ = template_funcs::DSQR(hi[COL_ITH] - lo[COL_ITH]) / 12.0;
+
+	double V_X = VX * EZ * EZ, V_Z = VZ * EX * EX, V_XZ = VX * VZ;
+	double V = V_X + V_Z + V_XZ;
+
+	std::vector<double> S1(P, 0.0), ST(P, 0.0);
+	S1[COL_ETAI] = V_X / V; ST[COL_ETAI] = (V_X + V_XZ) / V;
+	S1[COL_ITH] = V_Z / V; ST[COL_ITH] = (V_Z + V_XZ) / V;
+
+	sensitivity::sa_result res;
+	bool passed = sensitivity::sobol_indices(lo, hi, opts, res);
+
+	for (int p = 0; p < P && passed; p++) {
+		if (fabs(res.S1[p] - S1[p]) > tol || fabs(res.ST[p] - ST[p]) > tol) passed = false;
+	}
+
+	if (loud) {
+		std::cout << "testing::sobol_indices_analytic: " << (passed ? "passed" : "failed") << "\n";
+		if (!passed && static_cast<int>(res.S1.size()) == P) {
+			std::cout << "etai: S1 = " << res.S1[COL_ETAI] << " (" << S1[COL_ETAI] << "), ST = " << res.ST[COL_ETAI] << " (" << ST[COL_ETAI] << ")\n";
+			std::cout << "Ith: S1 = " << res.S1[COL_ITH] << " (" << S1[COL_ITH] << "), ST = " << res.ST[COL_ITH] << " (" << ST[COL_ITH] << ")\n";
+		}
+	}
+
+	return passed;
+}
@@ -6,7 +6,23 @@
 
 namespace testing {
 	
-	 
+	bool device_population_ec_laser(int n_devices = 1000, bool loud = true);
+
+	bool device_population_column_write(bool loud = true);
+
+	bool pipeline_exactly_once(int n_items = 100000, bool loud = true);
+
+	bool li_workflow_missing_file(bool loud = true);
+
+	bool c_api_strides(bool loud = true);
+
+	bool data_prep_co_sort(int n_rows = 400009, int n_threads = 5, bool loud = true);
+
+	bool data_prep_dedupe_resample(bool loud = true);
+
+	bool sobol_sequence_reference(bool loud = true);
+
+	bool sobol_indices_analytic(bool loud = true);
 
 }
 
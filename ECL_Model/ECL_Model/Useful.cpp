@@ -82,31 +82,12 @@ void useful_funcs::read_into_vector(std::string &filename, std::vector<double> &
 	// R. Sheehan 11 - 9 - 2017
 
 	try{
-		std::ifstream the_file; 
-		the_file.open(filename, std::ios_base::in);
-
-		if(the_file.is_open()){
-
-			if(loud) std::cout<<filename<<" opened for reading\n"; 
-
-			double value; 
-			n_pts = 0;
-			while(the_file >> value){
-				data.push_back(value);
-				n_pts++; 
-			}
-
-			if(loud) std::cout<<template_funcs::toString(n_pts)<<" data were read from "<<filename<<"\n"; 
-
-			the_file.close(); 		
-		}
-		else{
+		if( !try_read_into_vector(filename, data, n_pts, loud) ){
 			std::string reason; 
 			reason = "Error: void read_into_vector(std::string &filename, std::vector<double> &data)\n"; 
 			reason += "Cannot open: " + filename + "\n"; 
 			throw std::invalid_argument(reason); 
 		}
-		
 	}
 	catch(std::invalid_argument &e){
 		useful_funcs::exit_failure_output(e.what());
@@ -114,6 +95,38 @@ void useful_funcs::read_into_vector(std::string &filename, std::vector<double> &
 	}
 }
 
+bool useful_funcs::try_read_into_vector(std::string &filename, std::vector<double> &data, int &n_pts, bool loud)
+{
+	// read data from a file into a vector
+	// returns false if the file cannot be opened rather than exiting
+	// use this version from worker threads, where one bad file must not end the program
+
+	std::ifstream the_file; 
+	the_file.open(filename, std::ios_base::in);
+
+	n_pts = 0;
+
+	if(the_file.is_open()){
+
+		if(loud) std::cout<<filename<<" opened for reading\n"; 
+
+		double value; 
+		while(the_file >> value){
+			data.push_back(value);
+			n_pts++; 
+		}
+
+		if(loud) std::cout<<template_funcs::toString(n_pts)<<" data were read from "<<filename<<"\n"; 
+
+		the_file.close(); 
+
+		return true;
+	}
+	else{
+		return false;
+	}
+}
+
 //double useful_funcs::test_func(double (*f)(int, int), int a, int b)
 //{
 //	return (*f)(a, b); 
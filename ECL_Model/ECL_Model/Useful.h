@@ -12,6 +12,8 @@ namespace useful_funcs{
 
 	void read_into_vector(std::string &filename, std::vector<double> &data, int &n_pts, bool loud = false); 
 
+	bool try_read_into_vector(std::string &filename, std::vector<double> &data, int &n_pts, bool loud = false); 
+
 	//double test_func( double (*f)(int, int), int a, int b); 
 
 }